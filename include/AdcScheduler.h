@@ -0,0 +1,114 @@
+#ifndef ADCSCHEDULER_H
+#define ADCSCHEDULER_H
+
+#include <Arduino.h>
+#include "BatteryManager.h"
+
+// Number of BatteryManager instances (ADC channels) the scheduler serves.
+#ifndef ADC_SCHEDULER_MAX_CHANNELS
+#define ADC_SCHEDULER_MAX_CHANNELS 4
+#endif
+
+// Readings buffered per channel, a power of two up to 128.
+#ifndef ADC_SCHEDULER_RING
+#define ADC_SCHEDULER_RING 8
+#endif
+
+/**
+ * Shared ADC sampling for all BatteryManager instances.
+ *
+ * On AVR the converter runs on its own, either auto-triggered by the Timer0
+ * overflow that already drives millis() (the default, about 977 conversions
+ * per second at 16 MHz) or free-running (a conversion every 13 ADC clocks,
+ * about 9.6k per second at the default prescaler). The ADC interrupt stores
+ * each result in its channel's ring buffer and moves the multiplexer to the
+ * next channel, round-robin. The ISR only writes a ring's head and service()
+ * only its tail, so reading needs no locking and the main loop never waits
+ * for a conversion.
+ *
+ * Each channel gets rate / channels readings per second, so service() has to
+ * run at least every ADC_SCHEDULER_RING * channels / rate seconds or readings
+ * are dropped (getOverruns()). With 4 packs and a ring of 8 that is every
+ * 32 ms with the Timer0 trigger, which is plenty for a battery, but every
+ * 3 ms free-running; use FREE_RUNNING only for a fast-changing input.
+ *
+ * Other boards (ESP8266 has a single ADC input and no conversion
+ * interrupt) fall back to one analogRead() per service() call.
+ *
+ * While the scheduler runs, nothing else may call analogRead(). Inputs
+ * that are not battery packs, like a current shunt, are attached with
+ * attachPin() and read with latest().
+ */
+class AdcScheduler
+{
+public:
+  enum TriggerMode
+  {
+    FREE_RUNNING,
+    TIMER0_OVERFLOW
+  };
+
+  // Add a battery pack. Only while stopped. Returns false if full.
+  static bool attach(BatteryManager *manager);
+
+  // Add a plain input (e.g. a current shunt) read with latest(). Only while stopped. Returns false if full.
+  static bool attachPin(uint8_t pin);
+
+  // Channel index of a pin in attach order, -1 if it is not attached.
+  static int8_t channelOf(uint8_t pin);
+
+  static bool isRunning() { return _running; }
+
+  // Seed every pack with one reading and start converting.
+  static void begin(TriggerMode mode = TIMER0_OVERFLOW);
+
+  // Stop converting and give the ADC back to analogRead().
+  static void stop();
+
+  // Feed every buffered reading to its BatteryManager. Returns the number fed.
+  static uint8_t service();
+
+  // Most recent reading of a channel (index in attach order).
+  static uint16_t latest(uint8_t index);
+
+  // Readings waiting for service().
+  static uint8_t available(uint8_t index);
+
+  // Readings dropped because service() did not keep up.
+  static uint16_t getOverruns(uint8_t index);
+
+  static uint32_t getConversions();
+
+  static uint8_t getChannelCount() { return _channelCount; }
+
+  // Store a finished conversion and select the next channel. Called from the ADC interrupt.
+  static void onConversion(uint16_t value);
+
+private:
+  struct Channel
+  {
+    BatteryManager *manager;             // nullptr for a plain input
+    uint8_t pin;
+    uint8_t adcChannel;                  // Multiplexer channel of the pack's pin
+    volatile uint16_t ring[ADC_SCHEDULER_RING];
+    volatile uint8_t head;               // Written by the ISR only
+    volatile uint8_t tail;               // Written by service() only
+    volatile uint16_t overruns;
+  };
+
+  // Add a channel for a pin, fed to manager (may be nullptr).
+  static bool attachChannel(uint8_t pin, BatteryManager *manager);
+
+  // Select the multiplexer input of a channel.
+  static void selectChannel(uint8_t index);
+
+  static Channel _channels[ADC_SCHEDULER_MAX_CHANNELS];
+  static uint8_t _channelCount;
+  static volatile uint8_t _current;  // Channel of the conversion that finishes next
+  static volatile uint8_t _selected; // Channel the multiplexer is set to
+  static volatile uint32_t _conversions;
+  static bool _running;
+  static bool _pipelined;            // Free-running: the selection applies one conversion later
+};
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef BATTERYENERGY_H
+#define BATTERYENERGY_H
+
+#include <Arduino.h>
+#include "BatteryManager.h"
+#include "EepromKvStore.h"
+#include "SramDevice.h"
+
+/**
+ * Coulomb counter for one BatteryManager pack.
+ *
+ * update() integrates the pack current over the time since the last call,
+ * in microamp-hours with the sub-uAh remainder carried over, so nothing
+ * is lost to rounding however often it runs. The current comes from a
+ * shunt amplifier on an ADC pin or, without one, from a motor model
+ * (idle current plus a share of the full-speed current per duty).
+ *
+ * Merging with the voltage model:
+ * - the current is handed to the BatteryManager for its IR-drop compensation;
+ * - under load the charge is pure coulomb counting, which the voltage
+ *   cannot follow;
+ * - at rest (current below the rest threshold for the minimum rest time,
+ *   so the voltage has recovered from the load) the open-circuit voltage is
+ *   trustworthy, and the count is pulled towards it with a 16 s time
+ *   constant, weighted by the time between updates, which cancels the
+ *   counter's drift.
+ *
+ * While AdcScheduler runs, analogRead() is off limits: attach the shunt pin
+ * with AdcScheduler::attachPin() and update() reads its latest value.
+ *
+ * Remaining charge, throughput and equivalent full cycles are checkpointed
+ * to an EepromKvStore key or a SramDevice address (with a CRC, so a
+ * battery-backed or still-powered SRAM survives an MCU reset), but only
+ * after checkpointInterval and when the charge moved by checkpointStep,
+ * to spare the EEPROM.
+ *
+ * Runtime prediction divides the remaining charge by an EMA of the current
+ * once per update; getRuntimeMinutes() just returns the result.
+ */
+class BatteryEnergy
+{
+public:
+  // Constructor. capacityMilliampHours is the rated capacity of the pack.
+  BatteryEnergy(BatteryManager *manager, uint32_t capacityMilliampHours);
+
+  // Measure current through a shunt amplifier: (reading - zeroCounts) * microampsPerCount.
+  // With AdcScheduler running, the pin must be attached with AdcScheduler::attachPin().
+  void setShunt(int pin, uint16_t zeroCounts, uint32_t microampsPerCount);
+
+  // Estimate current from motor duty when there is no shunt.
+  void setMotorModel(uint16_t idleMilliamps, uint16_t fullSpeedMilliamps);
+
+  // Current motor duty, 0-255 (e.g. the average speed given to the motor driver).
+  void setMotorDuty(uint8_t duty) { _motorDuty = duty; }
+
+  // Below this current the pack counts as resting (default 50 mA).
+  void setRestCurrent(uint16_t milliamps) { _restMilliamps = milliamps; }
+
+  // Time the pack must rest before the voltage model is trusted (default 30 s).
+  void setMinimumRest(uint32_t restMillis) { _minimumRest = restMillis; }
+
+  // Checkpoint to a key of a wear-leveled EEPROM store.
+  void checkpointTo(EepromKvStore *store, uint8_t key);
+
+  // Checkpoint to an SRAM address (Record plus a CRC-8).
+  void checkpointTo(SramDevice *sram, uint16_t address);
+
+  // Minimum time and charge change between checkpoints (defaults 60 s and 1% of the capacity).
+  void setCheckpointThrottle(uint32_t intervalMillis, uint32_t stepMicroampHours);
+
+  // Restore the last checkpoint, or start from the voltage model. Returns true if a checkpoint was found.
+  bool begin();
+
+  // Integrate the current since the last call. Call periodically, e.g. from PowerScheduler.
+  void update();
+
+  // Save a checkpoint now, e.g. before deep sleep.
+  bool checkpoint();
+
+  // Pack current of the last update in mA, negative while charging.
+  int32_t getMilliamps() const { return _milliamps; }
+
+  uint32_t getRemainingMicroampHours() const { return _remaining; }
+
+  // State of charge in tenths of a percent.
+  uint16_t getStateOfCharge() const;
+
+  // Minutes left at the average current (0xFFFF when not discharging).
+  uint16_t getRuntimeMinutes() const { return _runtimeMinutes; }
+
+  // Equivalent full cycles: total discharged charge / capacity.
+  uint16_t getCycles() const { return _cycles; }
+
+  uint32_t getCheckpoints() const { return _checkpoints; }
+
+  // Persistent part of the state.
+  struct Record
+  {
+    uint32_t remaining;  // uAh left
+    uint32_t throughput; // uAh discharged since the last full cycle was counted
+    uint16_t cycles;
+  };
+
+private:
+  // Current in mA from the shunt or the motor model.
+  int32_t measure();
+
+  // Pull the count towards the voltage model for elapsed ms of rest.
+  void blendWithVoltage(uint32_t elapsed);
+
+  bool saveRecord();
+  bool loadRecord();
+
+  BatteryManager *_manager;
+  uint32_t _capacity; // uAh
+  int16_t _shuntPin;  // -1 for the motor model
+  uint16_t _shuntZero;
+  uint32_t _shuntMicroampsPerCount;
+  uint16_t _idleMilliamps;
+  uint16_t _fullSpeedMilliamps;
+  uint8_t _motorDuty;
+  uint16_t _restMilliamps;
+  uint32_t _minimumRest;
+  bool _resting;
+  unsigned long _restingSince;
+
+  EepromKvStore *_store;
+  uint8_t _storeKey;
+  SramDevice *_sram;
+  uint16_t _sramAddress;
+  uint32_t _checkpointInterval;
+  uint32_t _checkpointStep;
+  unsigned long _lastCheckpoint;
+  uint32_t _checkpointRemaining; // _remaining at the last checkpoint
+  uint32_t _checkpoints;
+
+  unsigned long _lastUpdate;
+  int32_t _remainder;      // mA * ms below one uAh (3600 mA * ms), negative while charging
+  uint32_t _remaining;     // uAh
+  uint32_t _throughput;    // uAh
+  uint16_t _cycles;
+  int32_t _milliamps;
+  int32_t _averageCurrent; // mA with 4 fractional bits
+  uint16_t _runtimeMinutes;
+};
+
+#endif
@@ -9,9 +9,8 @@
  *
  * Make a separate intance of this class for each battery pack.
  *
- * My plan is to:
- * - add a possibility for an interrupt pin to wake up the manager
- * - to
+ * To sleep between samples and wake on an interrupt pin, add the manager
+ * to PowerScheduler.
  *
  * The batteries in question are 18650 Li-ion batteries with 3,7V nominal voltage:
  * 4.2V: 100% (Fully charged)
@@ -20,6 +19,32 @@
  * 3.5V: ~25% charge
  * 3.2V: ~0-5% charge (Considered nearly empty)
  * <3.0V: Risk of damaging the battery if further discharged
+ *
+ * The level comes from an open-circuit voltage curve through these points
+ * (10% steps, in flash), linearly interpolated per cell: the pack voltage
+ * is divided by amountOfBatteries (cells in series). theoreticalMaxVoltage
+ * is the full pack voltage at ADC full scale, not the voltage of one cell,
+ * so the divider on the battery pin must bring that pack voltage down to
+ * the ADC reference. Under load the
+ * terminal voltage sags by current x internal resistance; with
+ * setInternalResistance() and setLoadCurrent()/setLoadFromSpeed() that
+ * drop is added back, so the level does not dip while the motors run.
+ *
+ * Sampling: call tick() (or poll(), which ticks at the configured
+ * interval) periodically. Each tick takes one ADC reading; every 4^b
+ * readings are summed and shifted by b for b extra bits of resolution,
+ * then pass a median-of-k spike filter and an exponential moving average,
+ * all in integer math. getBatteryAdjustedLevel() then only returns the
+ * level computed from the filtered value instead of doing a conversion.
+ * With several packs, attach them to AdcScheduler instead of ticking
+ * them: the ADC interrupt then takes the readings.
+ *
+ * Thresholds: every filtered sample moves a state machine between ok,
+ * warning, critical and shutdown (the BatteryThresholds levels). Dropping
+ * below a threshold is enough to get worse; getting better needs the level
+ * a hysteresis band above it. A new state must hold for the debounce time
+ * before the registered callbacks hear about it, so a motor start does not
+ * trigger a warning.
  */
 
 struct BatteryThresholds
@@ -29,6 +54,25 @@ struct BatteryThresholds
   int shutdownThreshold;
 };
 
+// Battery states, from good to bad.
+enum BatteryState
+{
+  BATTERY_OK = 0,
+  BATTERY_WARNING = 1,
+  BATTERY_CRITICAL = 2,
+  BATTERY_SHUTDOWN = 3
+};
+
+class BatteryManager;
+
+// Called when the debounced battery state changes.
+typedef void (*BatteryEventCallback)(BatteryManager *manager, BatteryState state, BatteryState previous, void *context);
+
+// Callbacks each BatteryManager can hold.
+#ifndef BATTERY_MAX_CALLBACKS
+#define BATTERY_MAX_CALLBACKS 2
+#endif
+
 class BatteryManager
 {
 public:
@@ -40,23 +84,135 @@ public:
    * @param batteryPin The pin where the battery voltage is read from
    * @param batteryThreshold The % battery level where the robot should enter deep sleep mode
    * @param amountOfBatteries The amount of batteries in the battery pack
-   * @param theoreticalMaxVoltage The theoretical max voltage of the battery pack
+   * @param theoreticalMaxVoltage The pack voltage that reads as ADC full scale (1023); the
+   *        voltage divider must scale this pack voltage to the ADC reference
    * @return A new BatteryManager object
    */
   BatteryManager(int batteryPin, int batteryThreshold, int amountOfBatteries, float theoreticalMaxVoltage);
+  // Two cells in series, full scale at 8.4 V (2 x 4.2 V), warnings below 25%.
   BatteryManager(int batteryPin);
   float getBatteryAdjustedLevel();
   bool isBatteryCritical();
   void setBatteryThresholds(int warningThreshold, int criticalThreshold, int shutdownThreshold);
 
+  /**
+   * Configure the sampling pipeline and restart it.
+   *
+   * @param extraBits Oversampling bits, 0-4 (4^extraBits readings per filtered sample)
+   * @param medianWindow Spike filter window, 1 (off) to BATTERY_MEDIAN_MAX, odd
+   * @param emaShift EMA weight of a new sample is 1/2^emaShift, 0 (off) to 8
+   * @param sampleIntervalMicros Time between readings when driven by poll()
+   */
+  void configureSampling(uint8_t extraBits, uint8_t medianWindow, uint8_t emaShift, uint32_t sampleIntervalMicros = 1000);
+
+  // Take one ADC reading. Returns true when it completed a filtered sample.
+  bool tick();
+
+  // Feed one raw reading taken elsewhere, e.g. by AdcScheduler.
+  bool addSample(uint16_t raw);
+
+  // Start every filter stage at one reading and take the state from it without debounce.
+  void seed(uint16_t raw);
+
+  // Call tick() if the sample interval has elapsed. Returns true when a filtered sample completed.
+  bool poll();
+
+  // Filtered pack voltage in millivolts (0 before the first filtered sample).
+  uint16_t getBatteryMillivolts() const { return filteredMillivolts; }
+
+  // Whether the filter has produced a value yet.
+  bool hasReading() const { return filteredSamples > 0; }
+
+  int getPin() const { return batteryPin; }
+
+  // Internal resistance of one cell, for load compensation (0 = off).
+  void setInternalResistance(uint16_t milliohmsPerCell);
+
+  // Current the pack delivers right now.
+  void setLoadCurrent(uint16_t milliamps);
+
+  // Estimate the load current from a motor speed (0-255) and the current drawn at full speed.
+  void setLoadFromSpeed(uint8_t speed, uint16_t fullSpeedMilliamps);
+
+  // Compensated open-circuit voltage of one cell in mV.
+  uint16_t getCellMillivolts() const { return cellMillivolts; }
+
+  // State of charge in tenths of a percent (0-1000).
+  uint16_t getStateOfCharge() const { return stateOfCharge; }
+
+  // State of charge of a cell with the given open-circuit voltage, in tenths of a percent.
+  static uint16_t stateOfChargeFromCell(uint16_t cellMillivolts);
+
+  // Register a state change callback. False if BATTERY_MAX_CALLBACKS are registered.
+  bool addEventCallback(BatteryEventCallback callback, void *context = nullptr);
+
+  // Band above a threshold the level must reach before the state improves (default 2%).
+  void setHysteresis(uint16_t tenthsOfPercent);
+
+  // Time a new state must hold before it is reported (default 1 s).
+  void setDebounce(uint32_t debounceMillis);
+
+  // The debounced state.
+  BatteryState getState() const { return batteryState; }
+
+  static const uint8_t BATTERY_MEDIAN_MAX = 5;
+
 private:
   BatteryThresholds thresholds = {25, 10, 5};
   int batteryPin;
   int batteryThreshold;
   int amountOfBatteries = 2;
-  float theoreticalMaxVoltage = 4.2;
+  float theoreticalMaxVoltage = 8.4; // Pack voltage at ADC full scale
   float getBatteryPercentage();
   float currentVoltage;
+
+  // Median of the spike filter window.
+  uint16_t median() const;
+
+  // Convert a filtered sample to millivolts and refresh the cached level.
+  void updateLevel(uint16_t filtered);
+
+  // The state a level (tenths of a percent) falls in, without hysteresis.
+  BatteryState classify(int32_t level) const;
+
+  // Move the state machine with the latest sample and run the callbacks.
+  void evaluateThresholds();
+
+  // Set the state, log the change and run the callbacks.
+  void changeState(BatteryState state);
+
+  uint8_t extraBits = 2;
+  uint8_t medianWindow = 3;
+  uint8_t emaShift = 3;
+  uint32_t sampleIntervalMicros = 1000;
+  unsigned long lastSampleMicros = 0;
+
+  uint32_t oversampleSum = 0;   // Readings summed so far for the next decimated sample
+  uint16_t oversampleCount = 0;
+  uint16_t medianRing[BATTERY_MEDIAN_MAX];
+  uint8_t medianIndex = 0;
+  uint8_t medianFill = 0;
+  uint32_t emaState = 0;        // Filter output scaled by 2^emaShift
+  uint32_t filteredSamples = 0; // Filtered samples since the pipeline was (re)configured
+  uint16_t filteredMillivolts = 0;
+  float cachedPercentage = 0;
+  uint16_t cellMillivolts = 0;
+  uint16_t stateOfCharge = 0;
+  uint16_t internalMilliohms = 0;
+  uint16_t loadMilliamps = 0;
+
+  struct EventCallback
+  {
+    BatteryEventCallback callback;
+    void *context;
+  };
+  EventCallback eventCallbacks[BATTERY_MAX_CALLBACKS];
+  uint8_t eventCallbackCount = 0;
+  BatteryState batteryState = BATTERY_OK;
+  BatteryState pendingState = BATTERY_OK; // State waiting for the debounce time
+  unsigned long pendingSince = 0;
+  uint16_t hysteresis = 20;
+  uint32_t debounceMillis = 1000;
 };
 ;
 
@@ -0,0 +1,37 @@
+#ifndef CRC_H
+#define CRC_H
+
+#include <Arduino.h>
+
+/**
+ * CRC helpers tuned for AVR.
+ *
+ * CRC-8 (poly 0x07, init 0x00) uses a 256 byte table kept in flash.
+ * CRC-16 (CCITT poly 0x1021, MSB first, init 0xFFFF) uses the bit-parallel
+ * byte update, which needs no table and only a handful of shifts per byte.
+ */
+class Crc
+{
+public:
+  static const uint8_t CRC8_INIT = 0x00;
+  static const uint16_t CRC16_INIT = 0xFFFF;
+
+  // Feed one byte into a running CRC-8.
+  static uint8_t crc8Update(uint8_t crc, uint8_t data);
+
+  // CRC-8 of a buffer, continuing from crc.
+  static uint8_t crc8(const uint8_t *data, uint16_t length, uint8_t crc = CRC8_INIT);
+
+  // Feed one byte into a running CRC-16.
+  static uint16_t crc16Update(uint16_t crc, uint8_t data)
+  {
+    uint8_t x = (crc >> 8) ^ data;
+    x ^= x >> 4;
+    return (crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x;
+  }
+
+  // CRC-16 of a buffer, continuing from crc.
+  static uint16_t crc16(const uint8_t *data, uint16_t length, uint16_t crc = CRC16_INIT);
+};
+
+#endif
@@ -1,10 +1,34 @@
-// Need to comment this out due to arduino, for now.
-// I'm sorry...
-#ifdef ESP8266
 #ifndef EEPROM24LC32A_H
 #define EEPROM24LC32A_H
 
-#include <Wire.h> // Include the Wire library for I2C communication
+#include <Arduino.h>
+#include "I2cBus.h" // All I2C traffic goes through the shared bus manager
+
+// Number of writeBytesAsync() requests that can be queued at once
+#ifndef EEPROM24LC32A_ASYNC_QUEUE
+#define EEPROM24LC32A_ASYNC_QUEUE 4
+#endif
+
+/**
+ * @brief Completion callback for writeBytesAsync().
+ *
+ * @param success true if every page was written and acknowledged, false on a bus error or timeout.
+ * @param context The pointer given to writeBytesAsync().
+ */
+typedef void (*EEPROMWriteCallback)(bool success, void *context);
+
+/**
+ * @brief Consumer for readStream(), called once per chunk.
+ *
+ * @param data The chunk, valid only during the call.
+ * @param length Number of bytes in the chunk.
+ * @param context The pointer given to readStream().
+ * @return false to stop the read.
+ */
+typedef bool (*EEPROMReadConsumer)(const uint8_t *data, size_t length, void *context);
+
+// Bytes the Wire library can send or receive in one transmission (2 of the sent ones go to the memory address)
+#define EEPROM24LC32A_WIRE_BUFFER I2C_WIRE_BUFFER
 
 /**
  * @class EEPROM24LC32A
@@ -17,6 +41,9 @@
 class EEPROM24LC32A
 {
 public:
+  static const uint8_t PAGE_SIZE = 32;      // Page write size of the 24LC32A
+  static const uint16_t DEVICE_SIZE = 4096; // 32Kb
+
   /**
    * @brief Constructor for the EEPROM24LC32A class.
    *
@@ -28,6 +55,11 @@ public:
    */
   EEPROM24LC32A(uint8_t deviceAddress = 0x50);
 
+  /**
+   * @brief Frees the page cache.
+   */
+  ~EEPROM24LC32A();
+
   /**
    * @brief Writes a single byte to a specific memory address.
    *
@@ -54,8 +86,9 @@ public:
   /**
    * @brief Writes multiple bytes to the EEPROM starting from a specific address.
    *
-   * This function writes a sequence of bytes to the EEPROM. Writing multiple
-   * bytes at once can be more efficient than writing individual bytes.
+   * This function writes a sequence of bytes to the EEPROM. The data is split
+   * at the 32-byte page boundaries so that no page write wraps around inside
+   * a page, and every page write is as full as the Wire buffer allows.
    *
    * @param memoryAddress The starting address in the EEPROM where the data will be written.
    * @param data A pointer to the array of data to be written.
@@ -76,18 +109,273 @@ public:
    */
   bool readBytes(uint16_t memoryAddress, uint8_t *buffer, size_t length);
 
+  /**
+   * @brief Checks whether the chip acknowledges its address.
+   *
+   * A chip in the middle of a write cycle does not acknowledge either.
+   *
+   * @return true if the chip answered.
+   */
+  bool isPresent();
+
+  /**
+   * @brief Streams a range of the EEPROM to a consumer without a full-size buffer.
+   *
+   * The memory address is sent once and the data is pulled in Wire-buffer
+   * sized chunks, relying on the chip's auto-incrementing address counter.
+   *
+   * @param memoryAddress The starting address.
+   * @param length The number of bytes to read.
+   * @param consumer Called for every chunk; returning false stops the read.
+   * @param context Passed to the consumer.
+   * @return true if all bytes were read and consumed.
+   */
+  bool readStream(uint16_t memoryAddress, size_t length, EEPROMReadConsumer consumer, void *context = nullptr);
+
+  /**
+   * @brief Sets the I2C clock, e.g. 400000 for fast mode.
+   *
+   * @param frequency Clock in Hz.
+   */
+  void setClock(uint32_t frequency);
+
+  /**
+   * @brief Enables or disables write combining for writeByte().
+   *
+   * When enabled, writeByte() only stores the byte in a one-page RAM buffer.
+   * Bytes landing in the same page are merged into a single page write, which
+   * is issued when a byte for another page arrives, before writeBytes(), or on
+   * flush(). Reads see the buffered bytes. Disabling flushes the buffer.
+   *
+   * @param enabled true to buffer writeByte() calls.
+   */
+  void setWriteCombining(bool enabled);
+
+  /**
+   * @brief Writes any bytes held by the write-combining buffer to the EEPROM.
+   *
+   * Queued asynchronous writes are finished first.
+   *
+   * @return true if the write was successful (or nothing was pending), false otherwise.
+   */
+  bool flush();
+
+  /**
+   * @brief Queues a write and returns at once.
+   *
+   * The data is written page by page from poll(): a page is only sent after
+   * the EEPROM has acknowledged the previous one, so the caller never spins
+   * for the ~5 ms write cycle. The data buffer is not copied and must stay
+   * valid until the callback has run.
+   *
+   * Synchronous reads and writes issued while the queue is busy first finish
+   * the queued writes, blocking. Bytes held by the write-combining buffer
+   * are flushed before the write is queued.
+   *
+   * @param memoryAddress The starting address in the EEPROM.
+   * @param data The data to write, owned by the caller.
+   * @param length The number of bytes to write.
+   * @param callback Optional completion callback.
+   * @param context Passed to the callback.
+   * @return true if queued, false if the queue is full or the flush failed.
+   */
+  bool writeBytesAsync(uint16_t memoryAddress, const uint8_t *data, size_t length,
+                       EEPROMWriteCallback callback = nullptr, void *context = nullptr);
+
+  /**
+   * @brief Advances the queued writes by at most one I2C transaction.
+   *
+   * Call this from loop(). It either checks whether the EEPROM has finished
+   * the previous page (one address-only probe) or sends the next page. Both
+   * are queued on the I2cBus at I2cBus::PRIORITY_EEPROM and the call runs
+   * one I2cBus::poll(), so other devices' queued traffic interleaves.
+   */
+  void poll();
+
+  /**
+   * @brief Whether queued writes are still in progress.
+   */
+  bool isBusy() const { return _asyncCount > 0 || _asyncWaiting || _asyncInFlight; }
+
+  /**
+   * @brief Number of queued writes, including the one in progress.
+   */
+  uint8_t pendingWrites() const { return _asyncCount; }
+
+  /**
+   * @brief Sets how long a page write may take before it counts as failed.
+   *
+   * The 24LC32A needs at most 5 ms per page. A missing or hung chip makes
+   * writes fail after this time instead of blocking forever.
+   *
+   * @param timeoutMs Timeout in milliseconds (default 10).
+   */
+  void setWriteTimeout(uint16_t timeoutMs) { _writeTimeoutMs = timeoutMs; }
+
+  /**
+   * @brief Enables a read-through page cache in RAM.
+   *
+   * Reads are served from up to `pages` cached 32-byte pages; a miss reads the
+   * whole page in one I2C request. Writes through this object update the
+   * cache once the chip has acknowledged them (a failed write drops the
+   * page), so it only goes stale if something else writes the chip.
+   *
+   * @param pages Number of pages to cache (32 bytes of RAM each), 0 to disable.
+   * @return true if the cache could be allocated.
+   */
+  bool enableCache(uint8_t pages);
+
+  /**
+   * @brief Drops every cached page.
+   */
+  void invalidateCache();
+
+  /**
+   * @brief Compares page writes with the EEPROM contents and skips unchanged ones.
+   *
+   * The current contents come from the cache when possible, otherwise they
+   * are read first, which is still far cheaper than a 5 ms write cycle and
+   * saves EEPROM wear.
+   *
+   * @param enabled true to skip writes that would not change anything.
+   */
+  void setSkipUnchangedWrites(bool enabled) { _skipUnchanged = enabled; }
+
+  /**
+   * @brief Cache and write statistics.
+   */
+  uint32_t getCacheHits() const { return _cacheHits; }
+  uint32_t getCacheMisses() const { return _cacheMisses; }
+  uint32_t getSkippedWrites() const { return _skippedWrites; }
+  void resetStats();
+
 private:
+  struct CachePage
+  {
+    uint16_t page;    // Address of the first byte of the page
+    uint16_t lastUse; // LRU stamp
+    bool valid;
+    uint8_t data[PAGE_SIZE];
+  };
+
+  CachePage *_cache;
+  uint8_t _cachePages;
+  uint16_t _cacheClock;
+  bool _skipUnchanged;
+  uint32_t _cacheHits;
+  uint32_t _cacheMisses;
+  uint32_t _skippedWrites;
+
+  /**
+   * @brief Reads straight from the chip, in chunks that fit the Wire buffer.
+   */
+  bool _readRaw(uint16_t memoryAddress, uint8_t *buffer, size_t length);
+
+  /**
+   * @brief Loads the chip's address counter for a sequential read.
+   */
+  bool _setReadAddress(uint16_t memoryAddress);
+
+  /**
+   * @brief Reads the next bytes from the chip's address counter (at most one Wire buffer).
+   */
+  bool _readNext(uint8_t *buffer, size_t length);
+
+  /**
+   * @brief Reads through the page cache.
+   */
+  bool _readCached(uint16_t memoryAddress, uint8_t *buffer, size_t length);
+
+  /**
+   * @brief Finds the cache slot holding a page, loading it on a miss.
+   *
+   * @return The slot, or nullptr if the page could not be read.
+   */
+  CachePage *_cacheLookup(uint16_t page);
+
+  /**
+   * @brief Copies freshly written bytes (within one page) into the cache if that page is cached.
+   */
+  void _cacheUpdate(uint16_t memoryAddress, const uint8_t *data, uint8_t length);
+
+  /**
+   * @brief Drops every cached page overlapping a range, e.g. after a failed write.
+   */
+  void _cacheInvalidate(uint16_t memoryAddress, size_t length);
+
+  struct AsyncWrite
+  {
+    uint16_t address;
+    const uint8_t *data;
+    size_t length;
+    size_t written;
+    EEPROMWriteCallback callback;
+    void *context;
+  };
+
+  AsyncWrite _asyncQueue[EEPROM24LC32A_ASYNC_QUEUE];
+  uint8_t _asyncHead;            // Write in progress
+  uint8_t _asyncCount;
+  bool _asyncWaiting;            // A page was sent and is not acknowledged yet
+  unsigned long _asyncStarted;   // millis() when the last page was sent
+  uint8_t _asyncSent;            // Bytes of the page waiting to be acknowledged
+  uint16_t _writeTimeoutMs;
+  I2cTransaction _asyncTransaction; // Page write or probe queued on the I2cBus
+  uint8_t _asyncHeader[2];          // Memory address of the queued page write
+  bool _asyncInFlight;              // _asyncTransaction is queued and not handled yet
+
+  /**
+   * @brief Handles the finished bus transaction and queues the next one.
+   */
+  void _asyncStep();
+
+  /**
+   * @brief Queues the page write (or, with no bytes, the acknowledge probe) on the bus.
+   */
+  void _submitAsync(const uint8_t *header, uint8_t headerLength, const uint8_t *data, uint8_t length);
+
+  /**
+   * @brief Completes the current async write and moves on to the next one.
+   */
+  void _finishAsync(bool success);
+
+  /**
+   * @brief Runs queued writes to completion, blocking.
+   */
+  void _drainAsync();
+
   uint8_t _deviceAddress; // The I2C device address of the EEPROM
 
+  bool _writeCombining;   // Whether writeByte() goes through the page buffer
+  uint16_t _pendingPage;  // Address of the first byte of the buffered page
+  uint32_t _pendingMask;  // Bit n set = byte n of the buffered page is pending
+  uint8_t _pendingData[PAGE_SIZE];
+
+  /**
+   * @brief Writes bytes that all lie within one page, as few transmissions as possible.
+   *
+   * @param memoryAddress The starting address.
+   * @param data The data to write.
+   * @param length The number of bytes, must not cross a page boundary.
+   * @return true if the write was successful, false otherwise.
+   */
+  bool _writePage(uint16_t memoryAddress, const uint8_t *data, uint8_t length);
+
+  /**
+   * @brief Copies pending write-combining bytes over data just read from the EEPROM.
+   */
+  void _overlayPending(uint16_t memoryAddress, uint8_t *buffer, size_t length);
+
   /**
    * @brief Waits until the EEPROM is ready for the next operation.
    *
    * The 24LC32A EEPROM takes some time to complete a write operation.
    * This function ensures that the EEPROM is ready before another operation is performed.
    * It does this by polling the EEPROM until it acknowledges, indicating it is ready.
+   *
+   * @return true once the EEPROM acknowledges, false if it did not within the write timeout.
    */
-  void _waitForWrite();
+  bool _waitForWrite();
 };
 
 #endif // EEPROM24LC32A_H
-#endif // ESP8266
@@ -0,0 +1,81 @@
+#ifndef EEPROMBANK_H
+#define EEPROMBANK_H
+
+#include <Arduino.h>
+#include "EEPROM24LC32A.h"
+
+/**
+ * Presents up to 8 24LC32A chips (0x50-0x57) as one linear address space of
+ * chipCount * 4 KB.
+ *
+ * Pages are striped across the chips: linear page p lives on chip
+ * p % chipCount. A large sequential write therefore keeps every chip busy
+ * at once: page writes go out through each chip's non-blocking queue and
+ * their 5 ms write cycles overlap, so throughput scales with the number of
+ * chips. A large read sends one address per chip and streams each chip's
+ * share straight into place.
+ */
+class EepromBank
+{
+public:
+  static const uint8_t MAX_CHIPS = 8;
+
+  // Constructor. chips is an array of chipCount caller-owned chips, chip 0 first.
+  EepromBank(EEPROM24LC32A *const *chips, uint8_t chipCount);
+
+  // Check that every chip answers. Returns false if one is missing.
+  bool begin();
+
+  // Write a byte at a linear address.
+  bool writeByte(uint16_t address, uint8_t data);
+
+  // Read a byte from a linear address.
+  uint8_t readByte(uint16_t address);
+
+  // Write a block, striped over the chips with overlapping write cycles.
+  bool writeBytes(uint16_t address, const uint8_t *data, size_t length);
+
+  // Read a block, one sequential read per chip.
+  bool readBytes(uint16_t address, uint8_t *buffer, size_t length);
+
+  // Total size of the linear address space in bytes.
+  uint32_t size() const { return (uint32_t)_chipCount * EEPROM24LC32A::DEVICE_SIZE; }
+
+  uint8_t getChipCount() const { return _chipCount; }
+
+private:
+  // State of one chip's share of a striped read, passed through readStream().
+  struct ReadState
+  {
+    EepromBank *bank;
+    uint8_t *buffer;     // Buffer of the whole read
+    uint16_t start;      // Linear address of buffer[0]
+    uint8_t chip;
+    uint16_t chipAddress; // Chip address of the next streamed byte
+  };
+
+  // readStream() consumer that scatters a chip's bytes to their linear positions.
+  static bool scatter(const uint8_t *data, size_t length, void *context);
+
+  // Completion callback for the striped page writes.
+  static void writeDone(bool success, void *context);
+
+  // Linear address to chip and chip address.
+  uint8_t chipOf(uint16_t address) const { return (address / EEPROM24LC32A::PAGE_SIZE) % _chipCount; }
+  uint16_t chipAddressOf(uint16_t address) const;
+
+  // Linear address of a chip address.
+  uint16_t linearAddressOf(uint8_t chip, uint16_t chipAddress) const;
+
+  // Whether a transfer fits in the address space. Logs an error if not.
+  bool inRange(uint16_t address, size_t length) const;
+
+  // Poll every chip's write queue once.
+  void pollAll();
+
+  EEPROM24LC32A *_chips[MAX_CHIPS];
+  uint8_t _chipCount;
+  bool _writeFailed;
+};
+
+#endif
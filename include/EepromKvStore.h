@@ -0,0 +1,160 @@
+#ifndef EEPROMKVSTORE_H
+#define EEPROMKVSTORE_H
+
+#include <Arduino.h>
+#include "EEPROM24LC32A.h"
+
+// Largest value a key can hold. A record adds 5 bytes and must fit in one 32-byte page.
+#ifndef EEPROM_KV_MAX_VALUE
+#define EEPROM_KV_MAX_VALUE 16
+#endif
+
+// Number of keys the RAM index can hold.
+#ifndef EEPROM_KV_MAX_KEYS
+#define EEPROM_KV_MAX_KEYS 16
+#endif
+
+#if EEPROM_KV_MAX_VALUE > 27
+#error "EEPROM_KV_MAX_VALUE must leave room for the 5 byte record header in a 32 byte page"
+#endif
+
+/**
+ * Wear-leveled key-value store for small configuration values (battery
+ * thresholds, motor acceleration profiles...) on the 24LC32A.
+ *
+ * The region is used as a circular log of records:
+ *   [key][length|flags][sequence lo][sequence hi][value...][CRC-8]
+ * A record never crosses a page, so every put() is a single page write.
+ * The newest record (highest sequence number) of a key wins; removing a
+ * key appends a tombstone.
+ *
+ * The page after the one being appended to is always free (only dead
+ * records). When the open page is full, appending moves on to that free
+ * page, and the still-live records of the oldest page (the one after it)
+ * are first compacted into it with new sequence numbers. Dead records and
+ * tombstones are dropped, and the oldest page becomes the new free page.
+ * Live records are always copied to a fresh page before the page holding
+ * them is reused, so a reset in the middle of garbage collection cannot
+ * lose them. Every page is rewritten once per lap, so writes spread over
+ * the whole region.
+ *
+ * begin() builds the RAM index with one streaming scan of the region. The
+ * index keeps a copy of every value, so get() needs no I2C traffic.
+ */
+class EepromKvStore
+{
+public:
+  static const uint8_t RECORD_OVERHEAD = 5; // Key, length, 16-bit sequence, CRC-8
+  static const uint8_t NO_KEY = 0xFF;       // Reserved, erased EEPROM reads as 0xFF
+
+  // Constructor. The region must be page aligned and at least two pages long.
+  EepromKvStore(EEPROM24LC32A *eeprom, uint16_t startAddress = 0, uint16_t size = EEPROM24LC32A::DEVICE_SIZE);
+
+  // Scan the region and build the index. Returns false on a bus error, or if
+  // the region holds more than EEPROM_KV_MAX_KEYS keys (writes are refused then).
+  bool begin();
+
+  // Erase the region (fill with 0xFF) and forget every key.
+  bool format();
+
+  // Store a value. Writing the value a key already holds does nothing.
+  bool put(uint8_t key, const void *value, uint8_t length);
+
+  template <typename T>
+  bool put(uint8_t key, const T &value) { return put(key, &value, sizeof(T)); }
+
+  // Copy up to length bytes of a value. Returns false if the key is not set.
+  bool get(uint8_t key, void *buffer, uint8_t length) const;
+
+  // Copy a value of exactly sizeof(T) bytes.
+  template <typename T>
+  bool get(uint8_t key, T &value) const { return valueLength(key) == sizeof(T) && get(key, &value, sizeof(T)); }
+
+  // Length of a value, 0 if the key is not set.
+  uint8_t valueLength(uint8_t key) const;
+
+  bool contains(uint8_t key) const { return findLive(key) >= 0; }
+
+  // Remove a key. Returns false if it was not set or the tombstone could not be written.
+  bool remove(uint8_t key);
+
+  // Number of keys set.
+  uint8_t count() const;
+
+  uint32_t getPageWrites() const { return _pageWrites; }
+
+  // Live records moved by garbage collection.
+  uint32_t getRelocations() const { return _relocations; }
+
+private:
+  static const uint8_t DELETED = 0x80; // Flag in the length byte of a tombstone
+  static const uint8_t LENGTH_MASK = 0x7F;
+
+  struct Entry
+  {
+    uint8_t key;
+    uint8_t length; // Value length, DELETED for a tombstone
+    uint16_t sequence;
+    uint16_t address; // EEPROM address of the record
+    uint8_t value[EEPROM_KV_MAX_VALUE];
+  };
+
+  // State of the boot scan, passed through readStream() as the context.
+  struct ScanState
+  {
+    EepromKvStore *store;
+    uint16_t pageIndex;
+    uint8_t fill;
+    uint8_t page[EEPROM24LC32A::PAGE_SIZE];
+  };
+
+  // readStream() consumer used by begin().
+  static bool scanChunk(const uint8_t *data, size_t length, void *context);
+
+  // Parse one page read by the scan and feed its records into the index.
+  void scanPage(uint16_t pageIndex, const uint8_t *page);
+
+  // Append a record to the log, garbage collecting pages as needed. Returns the record address, 0xFFFF on failure.
+  uint16_t append(uint8_t key, uint8_t length, const uint8_t *value);
+
+  // Move to the next (free) page and compact the oldest page's live records into it.
+  void reclaimNextPage();
+
+  // Copy the live records of a page into the open page image, drop its tombstones.
+  void carryOver(uint16_t pageIndex);
+
+  // Encode a record into the open page image at _fill.
+  void encode(uint8_t key, uint8_t length, uint16_t sequence, const uint8_t *value);
+
+  // Index of a key's entry (live or tombstone), -1 if none.
+  int8_t find(uint8_t key) const;
+
+  // Index of a key's entry if it is not a tombstone, -1 otherwise.
+  int8_t findLive(uint8_t key) const;
+
+  uint16_t pageAddress(uint16_t pageIndex) const { return _start + pageIndex * EEPROM24LC32A::PAGE_SIZE; }
+  uint16_t pageOf(uint16_t address) const { return (address - _start) / EEPROM24LC32A::PAGE_SIZE; }
+
+  // Sequence numbers wrap; a is newer if it is less than half the range ahead of b.
+  static bool newer(uint16_t a, uint16_t b) { return (int16_t)(a - b) > 0; }
+
+  EEPROM24LC32A *_eeprom;
+  uint16_t _start;
+  uint16_t _pageCount;
+
+  Entry _entries[EEPROM_KV_MAX_KEYS];
+  uint8_t _entryCount;
+
+  uint8_t _page[EEPROM24LC32A::PAGE_SIZE]; // Image of the page being appended to
+  uint16_t _openPage;
+  uint8_t _fill;      // Bytes of _page used by records
+  bool _dirty;        // _page differs from the chip before _fill
+  uint16_t _sequence; // Next sequence number
+  bool _haveNewest;   // The scan found at least one record
+  bool _indexOverflow; // The scan found more keys than the index holds, writes are refused
+
+  uint32_t _pageWrites;
+  uint32_t _relocations;
+};
+
+#endif
@@ -3,12 +3,13 @@
 
 #include <Arduino.h>
 #include "ShiftRegister74HC595.h"
+#include "SramDevice.h"
 
 /**
  * Class to interface with the HY62252A SRAM chip (32K x 8).
  * Supports direct GPIO control or two 74HC595 shift registers for address lines.
  */
-class HY62252A
+class HY62252A : public SramDevice
 {
 public:
   // Constructor for direct GPIO control of address and data lines.
@@ -22,16 +23,32 @@ public:
   void begin();
 
   // Write a byte to a specified address in the SRAM.
-  void writeByte(uint16_t address, uint8_t data);
+  void writeByte(uint16_t address, uint8_t data) override;
 
   // Read a byte from a specified address in the SRAM.
-  uint8_t readByte(uint16_t address);
+  uint8_t readByte(uint16_t address) override;
 
-  // Write a block of data starting at a specified address.
-  void writeBlock(uint16_t startAddress, const uint8_t *data, uint16_t length);
+  // Write a block of data starting at a specified address (burst, no per-byte verify).
+  void writeBlock(uint16_t startAddress, const uint8_t *data, uint16_t length) override;
 
-  // Read a block of data starting at a specified address.
-  void readBlock(uint16_t startAddress, uint8_t *buffer, uint16_t length);
+  // Read a block of data starting at a specified address (burst).
+  void readBlock(uint16_t startAddress, uint8_t *buffer, uint16_t length) override;
+
+  // Size of the chip in bytes (32K).
+  uint16_t size() const override { return 0x8000; }
+
+  // Switch which /CE pin is strobed, for several chips sharing the address and data buses.
+  void setChipEnablePin(uint8_t ce_pin);
+
+  // Forget the latched address, so the next access shifts out the whole
+  // address chain, e.g. after chip select bits on an address register changed.
+  void invalidateAddress() { _addressValid = false; }
+
+  // Whether reg is one of the address shift registers (its bits go out with every full latch).
+  bool isAddressRegister(const ShiftRegister74HC595 *reg) const { return reg && (reg == _shiftRegister1 || reg == _shiftRegister2); }
+
+  // Whether reg is not an address register but sits on the same daisy chain.
+  bool sharesAddressChain(const ShiftRegister74HC595 *reg) const;
 
   // Store a key-value pair at a specified SRAM address.
   void storeKeyValue(uint16_t startAddress, const char *key, const char *value);
@@ -43,6 +60,9 @@ private:
   // Set the address on the address bus using GPIO or shift registers.
   void setAddress(uint16_t address);
 
+  // Put an address on the bus, only touching the lines/registers that changed.
+  void latchAddress(uint16_t address);
+
   // Set the data bus to input or output mode.
   void setDataBusMode(uint8_t mode);
 
@@ -59,6 +79,10 @@ private:
   ShiftRegister74HC595 *_shiftRegister2; // Second shift register (upper address bits)
   uint8_t _addr_bits_in_shift_register1; // Number of address bits controlled by shiftRegister1
   uint8_t _addr_bits_in_shift_register2; // Number of address bits controlled by shiftRegister2
+  uint8_t _dataBusMode;                  // Current data bus mode (INPUT/OUTPUT), 0xFF if unknown
+  uint16_t _lastAddress;                 // Address currently latched on the bus
+  bool _addressValid;                    // Whether _lastAddress reflects the hardware
+  bool _chainedRegisters;                // Both shift registers share pins (daisy-chained)
 };
 
 #endif
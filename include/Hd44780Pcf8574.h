@@ -0,0 +1,100 @@
+#ifndef HD44780PCF8574_H
+#define HD44780PCF8574_H
+
+#include <Arduino.h>
+#include "I2cBus.h"
+
+/**
+ * HD44780 character LCD behind a PCF8574 I2C backpack, in 4-bit mode.
+ *
+ * Backpack wiring (the common one): P0 = RS, P1 = RW, P2 = E,
+ * P3 = backlight, P4-P7 = D4-D7.
+ *
+ * Every nibble costs two expander bytes (data with E high, then E low).
+ * Instead of one transmission per byte with delays around the strobe,
+ * the bytes of consecutive characters and commands are collected in a
+ * buffer and sent as one transmission of up to I2C_WIRE_BUFFER bytes.
+ * The I2C byte time already exceeds the 37 us the controller needs per
+ * character, so no delays are inserted; only clear() and home() (1.52 ms)
+ * mark the controller busy, and the next transmission waits for whatever
+ * is left of that time instead of a fixed delay.
+ *
+ * Transmissions are queued on the I2cBus at I2cBus::PRIORITY_DISPLAY and
+ * sent by the flush that queued them unless more urgent traffic is ahead.
+ * There are two buffers, so the next bytes can be collected while the
+ * previous ones are still queued; two queued buffers that fit in one
+ * transmission go out together.
+ */
+class Hd44780Pcf8574
+{
+public:
+  // Constructor.
+  Hd44780Pcf8574(uint8_t address, uint8_t cols, uint8_t rows);
+
+  // Run the 4-bit initialization sequence. Blocks for about 60 ms after power-up.
+  void begin();
+
+  // Queue one instruction byte (RS = 0).
+  void command(uint8_t value);
+
+  // Queue one character (RS = 1).
+  void write(uint8_t character);
+
+  // Queue a run of characters.
+  void write(const uint8_t *characters, uint8_t length);
+
+  void clear();
+  void home();
+  void setCursor(uint8_t col, uint8_t row);
+
+  void display();
+  void noDisplay();
+  void cursor();
+  void noCursor();
+  void blink();
+  void noBlink();
+  void backlight();
+  void noBacklight();
+
+  // Store a 5x8 glyph (8 rows, low 5 bits used) in CGRAM slot 0-7.
+  void createChar(uint8_t slot, const uint8_t pattern[8]);
+
+  // Queue the collected bytes on the I2cBus and run it once.
+  void flush();
+
+  // Flush and wait until every byte has been sent.
+  void sync();
+
+  // Whether the controller is still executing a slow command.
+  bool isBusy() const { return (long)(micros() - _busyUntil) < 0; }
+
+  // Bytes currently queued.
+  uint8_t queued() const { return _length; }
+
+private:
+  // Queue a byte as two nibbles; mode is 0 for instructions, RS for data.
+  void send(uint8_t value, uint8_t mode);
+
+  // Queue one nibble (high half of value) with its enable strobe.
+  void sendNibble(uint8_t value, uint8_t mode);
+
+  // Wait for the rest of the controller's busy time.
+  void waitReady();
+
+  // Send the queued bytes and mark the controller busy for busyMicros.
+  void busyFor(uint16_t busyMicros);
+
+  uint8_t _address;
+  uint8_t _cols;
+  uint8_t _rows;
+  uint8_t _backlight;      // Backlight bit or 0
+  uint8_t _displayControl; // Display, cursor and blink bits
+  uint8_t _buffers[2][I2C_WIRE_BUFFER];
+  I2cTransaction _transactions[2]; // Transmission of each buffer, done when it may be refilled
+  uint8_t _current;                // Buffer being filled
+  uint8_t *_buffer;                // _buffers[_current]
+  uint8_t _length;
+  unsigned long _busyUntil; // micros() when the last slow command has finished
+};
+
+#endif
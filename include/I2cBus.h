@@ -0,0 +1,141 @@
+#ifndef I2CBUS_H
+#define I2CBUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// Bytes the Wire library can send or receive in one transmission.
+#ifdef BUFFER_LENGTH
+#define I2C_WIRE_BUFFER BUFFER_LENGTH
+#else
+#define I2C_WIRE_BUFFER 32
+#endif
+
+// Number of devices I2cBus keeps bus time statistics for.
+#ifndef I2C_BUS_MAX_DEVICES
+#define I2C_BUS_MAX_DEVICES 8
+#endif
+
+struct I2cTransaction;
+
+// Called when a queued transaction has completed.
+typedef void (*I2cCallback)(I2cTransaction *transaction, void *context);
+
+/**
+ * Descriptor for one queued I2C transaction: an optional write followed by
+ * an optional read. Owned by the caller and must stay alive (with its
+ * buffers) until done is set.
+ *
+ * A transaction with neither write nor read bytes is an address-only
+ * transmission (an acknowledge probe).
+ */
+struct I2cTransaction
+{
+  uint8_t address;          // 7-bit device address
+  const uint8_t *header;    // Bytes sent before writeData (e.g. a memory address), may be nullptr
+  uint8_t headerLength;
+  const uint8_t *writeData; // Bytes to send, may be nullptr
+  uint8_t writeLength;
+  uint8_t *readBuffer;      // Buffer for the reply, may be nullptr
+  uint8_t readLength;
+  uint8_t priority;         // Higher runs first, FIFO within a priority
+  bool batchable;           // Write may share one transmission with other batchable writes to the device
+  I2cCallback callback;     // Optional, called on completion
+  void *context;            // Passed to the callback
+  volatile uint8_t status;  // endTransmission() code, I2cBus::SHORT_READ, 0 on success
+  volatile bool done;       // Set when the transaction has completed
+  I2cTransaction *next;     // Queue link, used by I2cBus
+};
+
+/**
+ * Owner of the shared I2C bus (LCD, EEPROMs...).
+ *
+ * - begin() starts Wire once and sets the clock. The transaction helpers
+ *   call it on first use, so drivers no longer call Wire.begin() themselves.
+ * - write()/read()/probe() run a transaction immediately.
+ * - submit() queues a transaction; poll() runs the highest priority one,
+ *   so a driver can hand off work (e.g. a display refresh) and let it
+ *   interleave with others from loop(). Consecutive batchable writes to the
+ *   same device go out as one transmission. Hd44780Pcf8574 flushes and the
+ *   EEPROM24LC32A write queue go through here, the display at a higher
+ *   priority than the EEPROM page writes.
+ * - Bus time, transactions and bytes are counted per device address, to
+ *   see which peripheral is eating the bandwidth.
+ */
+class I2cBus
+{
+public:
+  static const uint8_t SHORT_READ = 5; // Status: the device sent fewer bytes than requested
+
+  // Priorities of the queued traffic of the drivers in this library
+  static const uint8_t PRIORITY_EEPROM = 1;
+  static const uint8_t PRIORITY_DISPLAY = 2;
+
+  // Start Wire (once) and set the clock, e.g. 400000 for fast mode.
+  static void begin(uint32_t clockHz = 100000);
+
+  static void setClock(uint32_t clockHz);
+  static uint32_t getClock() { return _clockHz; }
+
+  // Send header then data in one transmission. Returns the endTransmission() code.
+  static uint8_t write(uint8_t address, const uint8_t *header, uint8_t headerLength, const uint8_t *data, uint8_t dataLength);
+
+  static uint8_t write(uint8_t address, const uint8_t *data, uint8_t length) { return write(address, data, length, nullptr, 0); }
+
+  // Request length bytes. Returns the number of bytes received.
+  static uint8_t read(uint8_t address, uint8_t *buffer, uint8_t length);
+
+  // Address-only transmission. True if the device acknowledged.
+  static bool probe(uint8_t address);
+
+  // Queue a transaction. False if it is invalid or already queued.
+  static bool submit(I2cTransaction *transaction);
+
+  // Run the highest priority queued transaction. Returns false if the queue was empty.
+  static bool poll();
+
+  // Run poll() until the queue is empty.
+  static void drain();
+
+  static uint8_t queueDepth() { return _queueDepth; }
+
+  // Bus time in microseconds, transactions and bytes moved for a device (0 if never used).
+  static uint32_t getBusMicros(uint8_t address);
+  static uint32_t getTransactions(uint8_t address);
+  static uint32_t getBytes(uint8_t address);
+
+  static void resetStats();
+
+  // Log the per-device statistics.
+  static void printStats();
+
+private:
+  struct DeviceStats
+  {
+    uint8_t address;
+    uint32_t busMicros;
+    uint32_t transactions;
+    uint32_t bytes;
+  };
+
+  // Charge a transaction to a device.
+  static void account(uint8_t address, unsigned long start, uint16_t bytes);
+
+  static DeviceStats *findStats(uint8_t address);
+
+  // Put a transaction's header and write bytes into the open transmission.
+  static void sendWrite(const I2cTransaction *transaction);
+
+  // Finish a queued transaction and call its callback.
+  static void complete(I2cTransaction *transaction, uint8_t status);
+
+  static bool _started;
+  static uint32_t _clockHz;
+  static I2cTransaction *_queue;
+  static uint8_t _queueDepth;
+  static volatile bool _busy; // Guards against re-entrant poll()
+  static DeviceStats _stats[I2C_BUS_MAX_DEVICES];
+  static uint8_t _statsCount;
+};
+
+#endif
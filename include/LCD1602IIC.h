@@ -1,15 +1,15 @@
 #ifndef LCD1602IIC_H
 #define LCD1602IIC_H
 
-#include <Wire.h>
-#include <LiquidCrystal_I2C.h>
+#include <Arduino.h>
+#include "Hd44780Pcf8574.h"
 
 /**
  * LCD1602IIC Class
  *
  * This class provides an interface to control a 1602 I2C LCD screen
- * using the NodeMCUv2 (ESP8266). It wraps around the LiquidCrystal_I2C
- * library to offer easier methods for common tasks such as printing
+ * using the NodeMCUv2 (ESP8266). It wraps around the Hd44780Pcf8574
+ * driver to offer easier methods for common tasks such as printing
  * text, controlling the cursor, and managing the display backlight.
  *
  * Class Description: Explains the purpose of the LCD1602IIC class,
@@ -23,7 +23,22 @@
  *
  * Private Members: Comments explain the role of private member variables,
  * such as storing the number of columns and rows of the LCD, and the
- * LiquidCrystal_I2C object for the actual communication with the display.
+ * Hd44780Pcf8574 object for the actual communication with the display.
+ *
+ * Frame buffer: clear(), home(), setCursor() and print() only change a
+ * cols x rows shadow copy of the screen in RAM. render() compares it with
+ * what the display is known to show and sends just the changed cells,
+ * moving the cursor only where a run of changed cells starts. A status
+ * screen redrawn every frame therefore costs a few bytes when little has
+ * changed, and clear() no longer costs the display's ~2 ms clear command.
+ * update(budgetMicros) does the same in time slices, for loops that
+ * cannot afford to block for a whole frame.
+ *
+ * Custom glyphs: writeGlyph() puts a 5x8 pattern in the frame buffer. The
+ * 8 CGRAM slots are handed out by pattern, least recently used first, but
+ * never a slot the current frame still shows. A pattern is only uploaded
+ * when it gets a slot, and the upload is sent by render()/update() ahead
+ * of the cells, within the same time budget.
  *
  */
 class LCD1602IIC
@@ -39,6 +54,7 @@ public:
    * @param lcdRows The number of rows on the LCD screen (default is 2).
    */
   LCD1602IIC(uint8_t lcdAddr = 0x27, uint8_t lcdCols = 16, uint8_t lcdRows = 2);
+  ~LCD1602IIC();
 
   /**
    * begin
@@ -50,7 +66,7 @@ public:
   /**
    * clear
    *
-   * Clears all characters from the display and sets the cursor to (0, 0).
+   * Fills the frame buffer with spaces and sets the cursor to (0, 0).
    */
   void clear();
 
@@ -85,6 +101,16 @@ public:
    */
   void noBacklight();
 
+  /**
+   * write
+   *
+   * Puts one character (or custom glyph 0-7) at the cursor and advances it.
+   * Characters past the end of the row are dropped.
+   *
+   * @param character The character code.
+   */
+  void write(uint8_t character);
+
   /**
    * print
    *
@@ -122,6 +148,31 @@ public:
    */
   void print(float number, int decimals = 2);
 
+  /**
+   * printPadded
+   *
+   * Prints an integer right-aligned in a fixed-width field, filled with
+   * '*' if it does not fit.
+   *
+   * @param number The integer to print.
+   * @param width Field width in characters.
+   * @param pad Padding character, '0' for leading zeros.
+   */
+  void printPadded(int32_t number, uint8_t width, char pad = ' ');
+
+  /**
+   * printPadded
+   *
+   * Prints a floating-point number right-aligned in a fixed-width field,
+   * filled with '*' if it does not fit.
+   *
+   * @param number The number to print.
+   * @param decimals The number of decimal places.
+   * @param width Field width in characters.
+   * @param pad Padding character, '0' for leading zeros.
+   */
+  void printPadded(float number, uint8_t decimals, uint8_t width, char pad = ' ');
+
   /**
    * cursor
    *
@@ -150,10 +201,109 @@ public:
    */
   void noBlink();
 
+  /**
+   * render
+   *
+   * Sends the cells that differ from what the display shows.
+   *
+   * @return The number of cells sent.
+   */
+  uint8_t render();
+
+  /**
+   * update
+   *
+   * Sends changed cells for at most about budgetMicros and resumes where it
+   * stopped on the next call, so loop() timing stays predictable. Always
+   * sends at least one changed cell, so the display catches up with a
+   * static frame within a bounded number of calls.
+   *
+   * @param budgetMicros Time this call may spend on the display.
+   * @return true if the display matches the frame buffer.
+   */
+  bool update(uint32_t budgetMicros);
+
+  /**
+   * invalidate
+   *
+   * Forgets what the display shows, so the next render() redraws every cell.
+   */
+  void invalidate();
+
+  /**
+   * getChar
+   *
+   * Returns the character in the frame buffer at the given cell.
+   *
+   * @param col The column number (0-based index).
+   * @param row The row number (0-based index).
+   * @return The character, 0 if the cell is off screen.
+   */
+  uint8_t getChar(uint8_t col, uint8_t row) const;
+
+  /**
+   * glyph
+   *
+   * Finds or assigns the CGRAM slot of a 5x8 pattern. A newly assigned
+   * slot is uploaded on the next render() or update().
+   *
+   * @param pattern 8 rows, top first, low 5 bits used.
+   * @return The slot (character code 0-7), -1 if all slots are in use by the frame.
+   */
+  int8_t glyph(const uint8_t pattern[8]);
+
+  /**
+   * writeGlyph
+   *
+   * Writes a custom glyph at the cursor, like write().
+   *
+   * @param pattern 8 rows, top first, low 5 bits used.
+   * @param fallback Character written if no CGRAM slot is free.
+   */
+  void writeGlyph(const uint8_t pattern[8], uint8_t fallback = '#');
+
+  // Number of glyph uploads to CGRAM so far.
+  uint32_t getGlyphUploads() const { return glyphUploads; }
+
+  uint8_t getCols() const { return cols; }
+  uint8_t getRows() const { return rows; }
+
 private:
-  LiquidCrystal_I2C lcd; // Object to interface with the I2C LCD
+  Hd44780Pcf8574 lcd;    // Object to interface with the I2C LCD
   uint8_t cols;          // Number of columns on the LCD
   uint8_t rows;          // Number of rows on the LCD
+
+  uint8_t *frame;        // What the screen should show, cols * rows
+  uint8_t *shown;        // What the screen is known to show
+  uint8_t cursorCol;     // Frame buffer cursor
+  uint8_t cursorRow;
+  uint8_t lcdCol;        // Where the display's own cursor is, 0xFF if unknown
+  uint8_t lcdRow;
+  bool underline;        // Underline cursor is on
+  bool blinking;         // Blinking cursor is on
+  uint16_t scanPosition; // Cell where the next render() or update() starts looking for changes
+
+  static const uint8_t NUMBER_FIELD_SIZE = 21; // A full 20 column row plus the terminator
+
+  // Print a formatted number, or '*' over the whole field if it did not fit.
+  void printField(const char *text, uint8_t length, uint8_t width);
+
+  static const uint8_t GLYPH_SLOTS = 8;
+  uint8_t glyphs[GLYPH_SLOTS][8]; // Pattern assigned to each CGRAM slot
+  uint16_t glyphLastUse[GLYPH_SLOTS];
+  uint16_t glyphClock;
+  uint8_t glyphAssigned;         // Bit per slot holding a pattern
+  uint8_t glyphPending;          // Bit per slot whose pattern is not uploaded yet
+  uint32_t glyphUploads;
+
+  // Whether any frame buffer cell shows a CGRAM slot.
+  bool glyphInFrame(uint8_t slot) const;
+
+  // Puts the display's cursor at a cell unless it is already there.
+  void moveLcdCursor(uint8_t col, uint8_t row);
+
+  // Sends changed cells within the budget. True if none are left.
+  bool drawChanged(uint32_t budgetMicros, uint8_t &sent);
 };
 
 #endif // LCD1602IIC_H
@@ -0,0 +1,53 @@
+#ifndef LCDBARGRAPH_H
+#define LCDBARGRAPH_H
+
+#include <Arduino.h>
+#include "LCD1602IIC.h"
+
+/**
+ * Bar graphs drawn into an LCD1602IIC frame buffer with custom glyphs.
+ *
+ * A horizontal bar resolves 5 steps per cell (one per pixel column), a
+ * vertical bar 8 (one per pixel row). Full cells use the display's built-in
+ * solid block (0xFF) and empty cells a space, so a bar needs at most one
+ * CGRAM slot: the partial cell at its tip. The glyphs are shared through
+ * the display's slot cache, so a battery gauge and a few wheel speed bars
+ * fit in the 8 slots, and a value that does not change costs nothing.
+ *
+ * Example: LcdBarGraph::horizontal(lcd, 0, 1, 10, battery.getBatteryAdjustedLevel(), 100);
+ */
+class LcdBarGraph
+{
+public:
+  static const uint8_t FULL_BLOCK = 0xFF; // Solid block in the HD44780 A00 character ROM
+
+  /**
+   * Draws a left-to-right bar.
+   *
+   * @param lcd The display.
+   * @param col First column of the bar.
+   * @param row Row of the bar.
+   * @param width Bar length in cells.
+   * @param value Value to show, clamped to 0..maxValue.
+   * @param maxValue Value of a full bar.
+   */
+  static void horizontal(LCD1602IIC &lcd, uint8_t col, uint8_t row, uint8_t width, float value, float maxValue);
+
+  /**
+   * Draws a bottom-to-top bar.
+   *
+   * @param lcd The display.
+   * @param col Column of the bar.
+   * @param bottomRow Row of the bottom cell.
+   * @param height Bar height in cells, growing upwards.
+   * @param value Value to show, clamped to 0..maxValue.
+   * @param maxValue Value of a full bar.
+   */
+  static void vertical(LCD1602IIC &lcd, uint8_t col, uint8_t bottomRow, uint8_t height, float value, float maxValue);
+
+private:
+  // Number of filled steps out of steps, rounded to the nearest.
+  static uint16_t filledSteps(float value, float maxValue, uint16_t steps);
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef NUMBERFORMAT_H
+#define NUMBERFORMAT_H
+
+#include <Arduino.h>
+
+/**
+ * Allocation-free number formatting into caller buffers.
+ *
+ * Replaces String(x) and Print's float printing where numbers are shown or
+ * logged. Floats are split once into 32-bit integer and fraction parts and
+ * the digits come from integer arithmetic only, so there is no repeated float
+ * division and no heap String. Values below 65536 use 16-bit division,
+ * which AVR does several times faster than 32-bit.
+ *
+ * Every function writes a zero-terminated string and returns its length,
+ * or 0 (with an empty string) if the buffer is too small. width pads on
+ * the left; with pad '0' the sign goes before the zeros ("-0042").
+ */
+class NumberFormat
+{
+public:
+  // Buffer sizes that fit any value without padding.
+  static const uint8_t INT_SIZE = 12;   // "-2147483648"
+  static const uint8_t FLOAT_SIZE = 22; // "-4294967040.123456789"
+
+  // Format an unsigned integer in base 2-16 (lower case digits).
+  static uint8_t formatUnsigned(char *buffer, uint8_t size, uint32_t value, uint8_t base = 10, uint8_t width = 0, char pad = ' ');
+
+  // Format a signed decimal integer.
+  static uint8_t formatInt(char *buffer, uint8_t size, int32_t value, uint8_t width = 0, char pad = ' ');
+
+  // Format a fixed-point value, e.g. scaled 1234 with 2 decimals is "12.34".
+  static uint8_t formatFixed(char *buffer, uint8_t size, int32_t scaled, uint8_t decimals, uint8_t width = 0, char pad = ' ');
+
+  // Format a float rounded to decimals (at most 9). Writes "nan", "inf" or "ovf" like Print.
+  static uint8_t formatFloat(char *buffer, uint8_t size, float value, uint8_t decimals = 2, uint8_t width = 0, char pad = ' ');
+
+private:
+  // Write the digits of value backwards, ending before end. Returns the first digit.
+  static char *digits(char *end, uint32_t value, uint8_t base);
+
+  // Write sign, padding and a digit string into the buffer.
+  static uint8_t emit(char *buffer, uint8_t size, bool negative, const char *text, uint8_t length, uint8_t width, char pad);
+
+  // Write "integer.fraction", the fraction zero-padded to decimals digits.
+  static uint8_t emitFixed(char *buffer, uint8_t size, bool negative, uint32_t integer, uint32_t fraction, uint8_t decimals, uint8_t width, char pad);
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef POWERSCHEDULER_H
+#define POWERSCHEDULER_H
+
+#include <Arduino.h>
+#include "BatteryManager.h"
+
+// Number of periodic tasks (battery packs included) the scheduler runs.
+#ifndef POWER_MAX_TASKS
+#define POWER_MAX_TASKS 6
+#endif
+
+// Periodic task or wake handler.
+typedef void (*PowerTaskCallback)(void *context);
+
+// Replaces the real sleep, e.g. to simulate it. Must return after duration ms of (virtual) time.
+typedef void (*PowerSleepHook)(uint32_t duration);
+
+enum PowerWakeSource
+{
+  WAKE_TIMER, // The next deadline came up
+  WAKE_PIN    // The wake pin fired
+};
+
+/**
+ * Sleep-until-next-deadline scheduler.
+ *
+ * runOnce() runs the periodic tasks that are due (for a BatteryManager:
+ * a burst of readings that completes one filtered sample, so its
+ * thresholds and callbacks are evaluated) and then sleeps until the
+ * earliest next deadline or until the wake pin fires.
+ *
+ * - AVR: power-down in watchdog steps (16 ms to 8 s), the rest in idle.
+ *   millis() and micros() stop in power-down, so the slept time is added
+ *   to the Arduino millis and Timer0 overflow counters afterwards and
+ *   timeouts based on either keep working. The watchdog is only accurate to about 10%. In
+ *   power-down an external interrupt only wakes on LOW; with another mode
+ *   the pin is seen at the next watchdog wake.
+ * - ESP8266: light sleep (the SDK sleeps inside delay() when
+ *   wifi_set_sleep_type(LIGHT_SLEEP_T) is set), in 10 ms slices so the
+ *   wake pin is noticed. Optional deep sleep for long waits: the chip
+ *   restarts from setup() afterwards (GPIO16 wired to RST), so anything
+ *   worth keeping must be saved first.
+ * - Other targets and simulation: delay(), or the sleep hook.
+ *
+ * Awake and sleep time are accumulated for a duty cycle figure.
+ */
+class PowerScheduler
+{
+public:
+  static void begin();
+
+  // Run callback every intervalMillis. Returns false if POWER_MAX_TASKS are in use.
+  static bool addTask(PowerTaskCallback callback, void *context, uint32_t intervalMillis);
+
+  // Take one filtered battery sample every intervalMillis.
+  static bool addBattery(BatteryManager *manager, uint32_t intervalMillis);
+
+  // Wake from sleep when the pin triggers (LOW, CHANGE, RISING, FALLING) and call the wake callback.
+  static void setWakePin(uint8_t pin, int mode, PowerTaskCallback callback = nullptr, void *context = nullptr);
+
+  // ESP8266: deep sleep waits of at least thresholdMillis (0 = never).
+  static void setDeepSleepThreshold(uint32_t thresholdMillis) { _deepSleepThreshold = thresholdMillis; }
+
+  static void setSleepHook(PowerSleepHook hook) { _sleepHook = hook; }
+
+  // Run the due tasks, then sleep until the next deadline or the wake pin.
+  static PowerWakeSource runOnce();
+
+  // millis() plus the time slept through the sleep hook.
+  static uint32_t now() { return millis() + _virtualMillis; }
+
+  // Time until the earliest task deadline.
+  static uint32_t timeToNextTask();
+
+  static uint32_t getAwakeMillis() { return _awakeMicros / 1000; }
+  static uint32_t getSleepMillis() { return _sleepMillis; }
+
+  // Share of the time spent awake, in tenths of a percent.
+  static uint16_t getDutyCycle();
+
+  static void resetStats();
+
+  // Log awake time, sleep time and duty cycle.
+  static void printStats();
+
+private:
+  struct Task
+  {
+    PowerTaskCallback callback;
+    void *context;
+    uint32_t interval;
+    uint32_t nextRun;
+  };
+
+  // Task callback that completes one filtered sample of a BatteryManager.
+  static void sampleBattery(void *context);
+
+  // Sleep the platform's way. Returns early if the wake pin fires.
+  static void sleepFor(uint32_t duration);
+
+  static void onWakePin();
+
+  static Task _tasks[POWER_MAX_TASKS];
+  static uint8_t _taskCount;
+  static int16_t _wakePin; // -1 if none
+  static int _wakeMode;
+  static PowerTaskCallback _wakeCallback;
+  static void *_wakeContext;
+  static volatile bool _pinWoke;
+  static PowerSleepHook _sleepHook;
+  static uint32_t _virtualMillis;
+  static uint32_t _deepSleepThreshold;
+  static uint64_t _awakeMicros;
+  static uint32_t _sleepMillis;
+};
+
+#endif
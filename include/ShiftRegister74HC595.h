@@ -20,9 +20,20 @@ public:
   // Set all pins (set all to HIGH)
   void setAll();
 
+  // Set the bits selected by mask on one register without latching them out.
+  // Call updateRegisters() afterwards to push the new state to the hardware.
+  void setBits(uint8_t registerIndex, uint8_t mask, uint8_t bits);
+
+  // Get the buffered state of one register
+  uint8_t getRegister(uint8_t registerIndex) const;
+
   // Update the shift registers (push the changes to the actual hardware)
   void updateRegisters();
 
+  // Whether other drives the same latch, clock and data pins, i.e. both are
+  // part of one daisy chain and every update shifts through all of it.
+  bool sharesPinsWith(const ShiftRegister74HC595 *other) const;
+
 private:
   uint8_t _latchPin;
   uint8_t _clockPin;
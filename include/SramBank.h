@@ -0,0 +1,74 @@
+#ifndef SRAMBANK_H
+#define SRAMBANK_H
+
+#include <Arduino.h>
+#include "HY62252A.h"
+#include "ShiftRegister74HC595.h"
+
+/**
+ * Presents 2-4 HY62252A chips that share the address and data buses as one
+ * flat 32-bit address space (chip = address >> 15).
+ *
+ * The chip is selected either by
+ * - one GPIO /CE pin per chip, or
+ * - extra address bits on spare shift register outputs (e.g. Q7 of the
+ *   upper address register, or a third register), feeding a 74HC139 style
+ *   decoder that is gated by the HY62252A's own /CE pin. A third register
+ *   needs its own latch, clock or data pin; select bits on an address
+ *   register go out with the next address latch.
+ *
+ * Block transfers are split at chip boundaries and every run within a chip
+ * is one burst, so a sequential transfer switches banks once per 32 KB.
+ */
+class SramBank
+{
+public:
+  static const uint32_t CHIP_SIZE = 0x8000;
+  static const uint8_t MAX_CHIPS = 4;
+
+  // Constructor for one GPIO /CE pin per chip.
+  SramBank(HY62252A *sram, const uint8_t *cePins, uint8_t chipCount);
+
+  // Constructor for chip select bits on shift register outputs.
+  SramBank(HY62252A *sram, ShiftRegister74HC595 *selectRegister, uint8_t firstSelectPin, uint8_t chipCount);
+
+  // Initialize the select lines. Call after HY62252A::begin().
+  void begin();
+
+  // Write a byte at a flat address.
+  void writeByte(uint32_t address, uint8_t data);
+
+  // Read a byte from a flat address.
+  uint8_t readByte(uint32_t address);
+
+  // Write a block, crossing chip boundaries as needed.
+  void writeBlock(uint32_t startAddress, const uint8_t *data, uint32_t length);
+
+  // Read a block, crossing chip boundaries as needed.
+  void readBlock(uint32_t startAddress, uint8_t *buffer, uint32_t length);
+
+  // Total size of the flat address space in bytes.
+  uint32_t size() const { return (uint32_t)_chipCount * CHIP_SIZE; }
+
+  uint8_t getChipCount() const { return _chipCount; }
+
+  // Number of times the selected chip had to change.
+  uint32_t getBankSwitches() const { return _bankSwitches; }
+
+private:
+  // Make chip the target of the next SRAM cycles, if it is not already.
+  void selectChip(uint8_t chip);
+
+  // Clip a transfer to the address space, false if nothing is left.
+  bool clip(uint32_t startAddress, uint32_t &length);
+
+  HY62252A *_sram;
+  uint8_t _cePins[MAX_CHIPS];            // GPIO /CE pins (GPIO mode)
+  ShiftRegister74HC595 *_selectRegister; // Register carrying the select bits (shift register mode)
+  uint8_t _firstSelectPin;               // Lowest select bit on _selectRegister
+  uint8_t _chipCount;
+  uint8_t _currentChip;                  // 0xFF until the first selection
+  uint32_t _bankSwitches;
+};
+
+#endif
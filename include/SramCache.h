@@ -0,0 +1,76 @@
+#ifndef SRAMCACHE_H
+#define SRAMCACHE_H
+
+#include <Arduino.h>
+#include "HY62252A.h"
+
+/**
+ * Small line-based write-back cache in MCU RAM in front of a HY62252A.
+ * Lines are filled and flushed with the chip's burst block transfers and
+ * evicted least-recently-used. Dirty lines only reach the chip on eviction
+ * or on an explicit flush().
+ */
+class SramCache
+{
+public:
+  // Constructor. lineSize must be a power of two (e.g. 8 lines of 16 bytes).
+  SramCache(HY62252A *sram, uint8_t numLines = 8, uint8_t lineSize = 16);
+  ~SramCache();
+
+  // Read a byte through the cache.
+  uint8_t readByte(uint16_t address);
+
+  // Write a byte into the cache; it reaches the SRAM when its line is flushed.
+  void writeByte(uint16_t address, uint8_t data);
+
+  // Read a block through the cache.
+  void readBlock(uint16_t startAddress, uint8_t *buffer, uint16_t length);
+
+  // Write a block through the cache.
+  void writeBlock(uint16_t startAddress, const uint8_t *data, uint16_t length);
+
+  // Write all dirty lines back to the SRAM.
+  void flush();
+
+  // Flush and then drop every line, e.g. after someone else wrote the SRAM directly.
+  void invalidate();
+
+  // Hit/miss statistics
+  uint32_t getHits() const { return _hits; }
+  uint32_t getMisses() const { return _misses; }
+  uint32_t getWritebacks() const { return _writebacks; }
+  void resetStats();
+
+private:
+  struct Line
+  {
+    uint16_t tag;     // SRAM address of the first byte in the line
+    uint16_t lastUse; // LRU stamp
+    bool valid;
+    bool dirty;
+  };
+
+  // Find the line holding address, loading it (and evicting another) on a miss.
+  // With fill == false a missed line is allocated without reading the SRAM,
+  // for callers that are about to overwrite the whole line.
+  uint8_t lookup(uint16_t address, bool fill = true);
+
+  // Write a single line back if it is dirty.
+  void flushLine(uint8_t index);
+
+  // Advance the LRU clock, renormalizing stamps when it wraps.
+  uint16_t nextStamp();
+
+  HY62252A *_sram;
+  uint8_t _numLines;
+  uint8_t _lineSize;
+  uint16_t _tagMask;  // Clears the in-line offset from an address
+  Line *_lines;       // Line metadata
+  uint8_t *_data;     // _numLines * _lineSize bytes of cached data
+  uint16_t _clock;    // LRU clock
+  uint32_t _hits;
+  uint32_t _misses;
+  uint32_t _writebacks;
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef SRAMDEVICE_H
+#define SRAMDEVICE_H
+
+#include <Arduino.h>
+
+/**
+ * Minimal byte/block interface shared by the HY62252A driver and the
+ * RAM-backed SramSimulator, so test code can run against either.
+ */
+class SramDevice
+{
+public:
+  virtual ~SramDevice() {}
+
+  virtual void writeByte(uint16_t address, uint8_t data) = 0;
+  virtual uint8_t readByte(uint16_t address) = 0;
+  virtual void writeBlock(uint16_t startAddress, const uint8_t *data, uint16_t length) = 0;
+  virtual void readBlock(uint16_t startAddress, uint8_t *buffer, uint16_t length) = 0;
+
+  // Number of addressable bytes.
+  virtual uint16_t size() const = 0;
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef SRAMINTEGRITY_H
+#define SRAMINTEGRITY_H
+
+#include <Arduino.h>
+#include "HY62252A.h"
+
+// Called by the scrubber for every block whose contents no longer match its CRC.
+typedef void (*SramCorruptionCallback)(uint16_t blockIndex, uint16_t address, void *context);
+
+/**
+ * Optional integrity layer on top of the HY62252A block APIs.
+ *
+ * A region of the SRAM is split into fixed-size blocks and a CRC-8 or CRC-16
+ * per block is kept in MCU RAM. Writes through this class keep the CRCs up
+ * to date; verifyBlock() checks one block on demand, and scrubStep() is a
+ * low-priority background scrubber that checks a bounded number of bytes
+ * per call and reports corrupted blocks.
+ */
+class SramIntegrity
+{
+public:
+  enum CrcWidth
+  {
+    CRC8 = 1,
+    CRC16 = 2
+  };
+
+  // Constructor. The region covers blockCount * blockSize bytes from baseAddress.
+  SramIntegrity(HY62252A *sram, uint16_t baseAddress, uint16_t blockSize, uint16_t blockCount, CrcWidth width = CRC16);
+  ~SramIntegrity();
+
+  // Compute the CRC of every block from the current SRAM contents.
+  void begin();
+
+  // Write data through to the SRAM and update the CRCs of the blocks it touches.
+  void writeBlock(uint16_t startAddress, const uint8_t *data, uint16_t length);
+
+  // Read data (no check, use verifyBlock() or the scrubber for that).
+  void readBlock(uint16_t startAddress, uint8_t *buffer, uint16_t length);
+
+  // Recompute one block's CRC and compare it with the stored one. False if it differs or the block is flagged.
+  bool verifyBlock(uint16_t blockIndex);
+
+  // Check up to maxBytes of the region, resuming where the previous call stopped.
+  // Returns the number of corrupted blocks found during this call.
+  uint16_t scrubStep(uint16_t maxBytes = 32);
+
+  // Register a callback for corrupted blocks found by the scrubber.
+  void onCorruption(SramCorruptionCallback callback, void *context = nullptr);
+
+  // Whether the scrubber, verifyBlock() or a partial write has flagged a block.
+  // The flag stays until the block is fully rewritten or resealed.
+  bool isBlockCorrupt(uint16_t blockIndex) const;
+
+  // Accept the current contents of a block as correct and clear its flag.
+  void resealBlock(uint16_t blockIndex);
+
+  uint16_t getCorruptCount() const { return _corruptCount; }
+
+  // Full passes the scrubber has completed over the region.
+  uint32_t getScrubPasses() const { return _scrubPasses; }
+
+private:
+  // CRC of one block read back from SRAM.
+  uint16_t computeBlockCrc(uint16_t blockIndex);
+
+  uint16_t storedCrc(uint16_t blockIndex) const;
+  void storeCrc(uint16_t blockIndex, uint16_t crc);
+  uint16_t crcInit() const;
+  uint16_t crcUpdate(uint16_t crc, const uint8_t *data, uint16_t length) const;
+  void markCorrupt(uint16_t blockIndex, bool corrupt);
+
+  HY62252A *_sram;
+  uint16_t _base;
+  uint16_t _blockSize;
+  uint16_t _blockCount;
+  CrcWidth _width;
+  uint8_t *_crcs;         // _blockCount * _width bytes
+  uint8_t *_corrupt;      // One bit per block
+  uint16_t _corruptCount;
+
+  uint16_t _scrubBlock;   // Block the scrubber is working on
+  uint16_t _scrubOffset;  // Bytes of _scrubBlock already fed into _scrubCrc
+  uint16_t _scrubCrc;     // Running CRC of the partially scrubbed block
+  uint32_t _scrubPasses;
+
+  SramCorruptionCallback _callback;
+  void *_callbackContext;
+};
+
+#endif
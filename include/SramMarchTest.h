@@ -0,0 +1,86 @@
+#ifndef SRAMMARCHTEST_H
+#define SRAMMARCHTEST_H
+
+#include <Arduino.h>
+#include "SramDevice.h"
+
+/**
+ * Result of a SramMarchTest run.
+ */
+struct SramTestReport
+{
+  bool passed;
+  uint32_t failures;          // Failing byte reads over all tests
+  uint8_t dataLinesStuckHigh; // Data lines that never read back 0
+  uint8_t dataLinesStuckLow;  // Data lines that never read back 1
+  uint8_t dataLineErrors;     // Data lines that differed in any failing read
+  uint16_t addressLineErrors; // Address lines that alias or are shorted
+  uint16_t firstFailures[4];  // Addresses of the first failing reads
+  uint8_t firstFailureCount;
+  uint32_t bytesMoved;        // Bytes read and written
+  uint32_t elapsedMicros;
+  uint32_t bytesPerSecond;
+};
+
+/**
+ * Full-chip memory test for the HY62252A (or the SramSimulator).
+ *
+ * - Data line test: walking ones/zeros at one address, finds stuck lines.
+ * - Address line test: writes to every power-of-two address and checks
+ *   they are unique, finds stuck and shorted address lines.
+ * - Walking ones: fills the whole chip with each single-bit pattern.
+ * - March C-: {w0; up(r0,w1); up(r1,w0); down(r0,w1); down(r1,w0); r0}
+ *
+ * Everything memory-wide uses the burst block transfers, in chunks of
+ * CHUNK bytes: each march element reads a chunk, checks it and writes the
+ * whole chunk back, so the per-cell order holds chunk by chunk.
+ */
+class SramMarchTest
+{
+public:
+  enum Test
+  {
+    DATA_LINES = 0x01,
+    ADDRESS_LINES = 0x02,
+    WALKING_ONES = 0x04,
+    MARCH_C_MINUS = 0x08,
+    ALL_TESTS = 0x0F
+  };
+
+  static const uint8_t CHUNK = 32;
+
+  SramMarchTest(SramDevice *sram);
+
+  // Run the selected tests and fill in the report.
+  const SramTestReport &run(uint8_t tests = ALL_TESTS);
+
+  bool testDataLines();
+  bool testAddressLines();
+  bool testWalkingOnes();
+  bool testMarchCMinus();
+
+  const SramTestReport &getReport() const { return _report; }
+
+  // Log the report.
+  void printReport() const;
+
+private:
+  // Write pattern to the whole chip.
+  void fill(uint8_t pattern);
+
+  // Check the whole chip holds expected. Returns false on any mismatch.
+  bool verify(uint8_t expected);
+
+  // One march element: read and check expected, then write pattern, chunk by chunk.
+  bool marchElement(bool ascending, uint8_t expected, uint8_t pattern);
+
+  // Read one byte and compare it with expected on the lines that are not stuck.
+  bool checkByte(uint16_t address, uint8_t expected);
+
+  void recordFailure(uint16_t address, uint8_t expected, uint8_t actual);
+
+  SramDevice *_sram;
+  SramTestReport _report;
+};
+
+#endif
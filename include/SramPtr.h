@@ -0,0 +1,221 @@
+#ifndef SRAMPTR_H
+#define SRAMPTR_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include "HY62252A.h"
+
+// avr-libc has no STL. Elsewhere the iterators carry the usual traits so
+// std::find, std::copy, std::accumulate etc. accept them.
+#ifndef __AVR__
+#include <iterator>
+#endif
+
+/**
+ * Proxy for one T stored in the HY62252A, returned by dereferencing a SramPtr.
+ * Reading converts to T, assigning writes through to the chip.
+ */
+template <typename T>
+class SramRef
+{
+public:
+  SramRef(HY62252A *sram, uint16_t address) : _sram(sram), _address(address) {}
+
+  operator T() const
+  {
+    T value;
+    _sram->readBlock(_address, (uint8_t *)&value, sizeof(T));
+    return value;
+  }
+
+  SramRef &operator=(const T &value)
+  {
+    _sram->writeBlock(_address, (const uint8_t *)&value, sizeof(T));
+    return *this;
+  }
+
+  SramRef &operator=(const SramRef &other)
+  {
+    return *this = (T)other;
+  }
+
+private:
+  HY62252A *_sram;
+  uint16_t _address;
+};
+
+/**
+ * Pointer-like handle to an array of T in the HY62252A. Supports the usual
+ * pointer arithmetic and random access; every dereference is one block
+ * transfer, so use SramRange for long linear scans.
+ */
+template <typename T>
+class SramPtr
+{
+public:
+  typedef ptrdiff_t difference_type;
+#ifndef __AVR__
+  typedef std::random_access_iterator_tag iterator_category;
+  typedef T value_type;
+  typedef void pointer;
+  typedef SramRef<T> reference;
+#endif
+
+  SramPtr() : _sram(nullptr), _address(0) {}
+  SramPtr(HY62252A *sram, uint16_t address) : _sram(sram), _address(address) {}
+
+  SramRef<T> operator*() const { return SramRef<T>(_sram, _address); }
+  SramRef<T> operator[](difference_type index) const { return SramRef<T>(_sram, _address + index * (difference_type)sizeof(T)); }
+
+  SramPtr &operator++()
+  {
+    _address += sizeof(T);
+    return *this;
+  }
+  SramPtr operator++(int)
+  {
+    SramPtr old = *this;
+    _address += sizeof(T);
+    return old;
+  }
+  SramPtr &operator--()
+  {
+    _address -= sizeof(T);
+    return *this;
+  }
+  SramPtr operator--(int)
+  {
+    SramPtr old = *this;
+    _address -= sizeof(T);
+    return old;
+  }
+  SramPtr &operator+=(difference_type n)
+  {
+    _address += n * (difference_type)sizeof(T);
+    return *this;
+  }
+  SramPtr &operator-=(difference_type n)
+  {
+    _address -= n * (difference_type)sizeof(T);
+    return *this;
+  }
+  SramPtr operator+(difference_type n) const { return SramPtr(_sram, _address + n * (difference_type)sizeof(T)); }
+  SramPtr operator-(difference_type n) const { return SramPtr(_sram, _address - n * (difference_type)sizeof(T)); }
+  difference_type operator-(const SramPtr &other) const
+  {
+    return ((difference_type)_address - (difference_type)other._address) / (difference_type)sizeof(T);
+  }
+
+  bool operator==(const SramPtr &other) const { return _address == other._address; }
+  bool operator!=(const SramPtr &other) const { return _address != other._address; }
+  bool operator<(const SramPtr &other) const { return _address < other._address; }
+  bool operator>(const SramPtr &other) const { return _address > other._address; }
+  bool operator<=(const SramPtr &other) const { return _address <= other._address; }
+  bool operator>=(const SramPtr &other) const { return _address >= other._address; }
+
+  uint16_t address() const { return _address; }
+
+private:
+  HY62252A *_sram;
+  uint16_t _address;
+};
+
+// n + ptr, as random access iterators allow
+template <typename T>
+SramPtr<T> operator+(typename SramPtr<T>::difference_type n, const SramPtr<T> &ptr)
+{
+  return ptr + n;
+}
+
+/**
+ * Read-only input iterator over T in the HY62252A that prefetches the next
+ * N elements into a small MCU buffer with one burst read, so a linear scan
+ * costs one burst per N elements instead of one transfer per element.
+ * The prefetch never reads past the end address of the range it came from.
+ */
+template <typename T, uint8_t N = 8>
+class SramIterator
+{
+public:
+#ifndef __AVR__
+  typedef std::input_iterator_tag iterator_category;
+  typedef T value_type;
+  typedef ptrdiff_t difference_type;
+  typedef const T *pointer;
+  typedef const T &reference;
+#endif
+
+  SramIterator(HY62252A *sram, uint16_t address, uint16_t limit)
+      : _sram(sram), _address(address), _limit(limit), _bufferStart(0), _bufferCount(0) {}
+
+  const T &operator*()
+  {
+    uint16_t offset = (_address - _bufferStart) / sizeof(T);
+    if (_bufferCount == 0 || _address < _bufferStart || offset >= _bufferCount)
+    {
+      prefetch();
+      offset = 0;
+    }
+    return _buffer[offset];
+  }
+
+  const T *operator->() { return &**this; }
+
+  SramIterator &operator++()
+  {
+    _address += sizeof(T);
+    return *this;
+  }
+  SramIterator operator++(int)
+  {
+    SramIterator old = *this;
+    _address += sizeof(T);
+    return old;
+  }
+
+  bool operator==(const SramIterator &other) const { return _address == other._address; }
+  bool operator!=(const SramIterator &other) const { return _address != other._address; }
+
+  uint16_t address() const { return _address; }
+
+private:
+  void prefetch()
+  {
+    uint16_t remaining = (_limit - _address) / sizeof(T);
+    _bufferCount = remaining < N ? remaining : N;
+    _bufferStart = _address;
+    _sram->readBlock(_address, (uint8_t *)_buffer, _bufferCount * sizeof(T));
+  }
+
+  HY62252A *_sram;
+  uint16_t _address;
+  uint16_t _limit;       // End address of the range, prefetch stops here
+  uint16_t _bufferStart; // SRAM address of _buffer[0]
+  uint8_t _bufferCount;  // Valid elements in _buffer
+  T _buffer[N];
+};
+
+/**
+ * A run of count elements of T starting at baseAddress, usable in range-for
+ * loops and with standard algorithms via begin()/end().
+ */
+template <typename T, uint8_t N = 8>
+class SramRange
+{
+public:
+  SramRange(HY62252A *sram, uint16_t baseAddress, uint16_t count)
+      : _sram(sram), _base(baseAddress), _end(baseAddress + count * sizeof(T)) {}
+
+  SramIterator<T, N> begin() const { return SramIterator<T, N>(_sram, _base, _end); }
+  SramIterator<T, N> end() const { return SramIterator<T, N>(_sram, _end, _end); }
+
+  SramPtr<T> data() const { return SramPtr<T>(_sram, _base); }
+  uint16_t size() const { return (_end - _base) / sizeof(T); }
+
+private:
+  HY62252A *_sram;
+  uint16_t _base;
+  uint16_t _end;
+};
+
+#endif
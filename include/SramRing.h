@@ -0,0 +1,141 @@
+#ifndef SRAMRING_H
+#define SRAMRING_H
+
+#include <Arduino.h>
+#include "HY62252A.h"
+#include "logger.h"
+
+/**
+ * FIFO ring buffer of fixed-size elements stored in the HY62252A.
+ * Only the head/tail bookkeeping lives in MCU RAM; the elements themselves
+ * are moved with the chip's burst block transfers. pushN/popN move a whole
+ * batch with at most two bursts (one on each side of the wrap point).
+ *
+ * T must be trivially copyable (plain structs, integers, floats).
+ */
+template <typename T>
+class SramRing
+{
+public:
+  /**
+   * @param sram The SRAM chip holding the elements.
+   * @param baseAddress First SRAM address used by the ring.
+   * @param capacity Number of elements; the ring uses capacity * sizeof(T) bytes.
+   *                 Clamped, with an error logged, if that runs past the end of the chip.
+   */
+  SramRing(HY62252A *sram, uint16_t baseAddress, uint16_t capacity)
+      : _sram(sram), _base(baseAddress), _capacity(capacity), _head(0), _tail(0), _count(0)
+  {
+    uint32_t available = baseAddress < _sram->size() ? (_sram->size() - baseAddress) / sizeof(T) : 0;
+    if (capacity > available)
+    {
+      Logger::error("SramRing: capacity " + String(capacity) + " does not fit in SRAM, clamped to " + String(available));
+      _capacity = available;
+    }
+  }
+
+  // Append one element, false if the ring is full.
+  bool push(const T &item)
+  {
+    return pushN(&item, 1) == 1;
+  }
+
+  // Remove the oldest element, false if the ring is empty.
+  bool pop(T &item)
+  {
+    return popN(&item, 1) == 1;
+  }
+
+  // Read the oldest element without removing it.
+  bool peek(T &item)
+  {
+    if (_count == 0)
+    {
+      return false;
+    }
+    _sram->readBlock(addressOf(_tail), (uint8_t *)&item, sizeof(T));
+    return true;
+  }
+
+  // Append up to n elements, returns how many fit.
+  uint16_t pushN(const T *items, uint16_t n)
+  {
+    if (n > _capacity - _count)
+    {
+      n = _capacity - _count;
+    }
+    uint16_t first = _capacity - _head; // Elements until the wrap point
+    if (first > n)
+    {
+      first = n;
+    }
+    _sram->writeBlock(addressOf(_head), (const uint8_t *)items, first * sizeof(T));
+    if (n > first)
+    {
+      _sram->writeBlock(_base, (const uint8_t *)(items + first), (n - first) * sizeof(T));
+    }
+    _head = advance(_head, n);
+    _count += n;
+    return n;
+  }
+
+  // Remove up to n of the oldest elements, returns how many were read.
+  uint16_t popN(T *items, uint16_t n)
+  {
+    if (n > _count)
+    {
+      n = _count;
+    }
+    uint16_t first = _capacity - _tail;
+    if (first > n)
+    {
+      first = n;
+    }
+    _sram->readBlock(addressOf(_tail), (uint8_t *)items, first * sizeof(T));
+    if (n > first)
+    {
+      _sram->readBlock(_base, (uint8_t *)(items + first), (n - first) * sizeof(T));
+    }
+    _tail = advance(_tail, n);
+    _count -= n;
+    return n;
+  }
+
+  // Drop everything (the SRAM contents are left as they are).
+  void clear()
+  {
+    _head = 0;
+    _tail = 0;
+    _count = 0;
+  }
+
+  uint16_t size() const { return _count; }
+  uint16_t capacity() const { return _capacity; }
+  bool empty() const { return _count == 0; }
+  bool full() const { return _count == _capacity; }
+
+private:
+  uint16_t addressOf(uint16_t index) const
+  {
+    return _base + index * sizeof(T);
+  }
+
+  uint16_t advance(uint16_t index, uint16_t n) const
+  {
+    index += n;
+    if (index >= _capacity)
+    {
+      index -= _capacity;
+    }
+    return index;
+  }
+
+  HY62252A *_sram;
+  uint16_t _base;
+  uint16_t _capacity;
+  uint16_t _head;  // Next slot to write
+  uint16_t _tail;  // Oldest element
+  uint16_t _count;
+};
+
+#endif
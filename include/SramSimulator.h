@@ -0,0 +1,63 @@
+#ifndef SRAMSIMULATOR_H
+#define SRAMSIMULATOR_H
+
+#include <Arduino.h>
+#include "SramDevice.h"
+
+/**
+ * RAM-backed stand-in for the HY62252A with injectable hardware faults,
+ * for validating test code (e.g. SramMarchTest) without a board.
+ *
+ * The backing storage is provided by the caller, so a full 32 KB chip can
+ * be simulated on the ESP8266 or the host, and a small one on AVR.
+ *
+ * Faults model the wiring problems seen on the breadboard:
+ * - data lines stuck at 0 or 1,
+ * - address lines stuck at 0 or 1 (aliasing two halves of the chip),
+ * - individual cells stuck at a value.
+ */
+class SramSimulator : public SramDevice
+{
+public:
+  static const uint8_t MAX_STUCK_CELLS = 4;
+
+  // Constructor. size must be a power of two.
+  SramSimulator(uint8_t *storage, uint16_t size);
+
+  void writeByte(uint16_t address, uint8_t data) override;
+  uint8_t readByte(uint16_t address) override;
+  void writeBlock(uint16_t startAddress, const uint8_t *data, uint16_t length) override;
+  void readBlock(uint16_t startAddress, uint8_t *buffer, uint16_t length) override;
+  uint16_t size() const override { return _size; }
+
+  // Force a data line (bit 0-7) to a fixed level.
+  void injectDataLineStuck(uint8_t line, bool level);
+
+  // Force an address line to a fixed level.
+  void injectAddressLineStuck(uint8_t line, bool level);
+
+  // Make one cell always read back value. False if all slots are used.
+  bool injectStuckCell(uint16_t address, uint8_t value);
+
+  // Remove all faults.
+  void clearFaults();
+
+private:
+  // Apply the address line faults and wrap to the chip size.
+  uint16_t mapAddress(uint16_t address) const;
+
+  // Apply the data line faults.
+  uint8_t mapData(uint8_t data) const;
+
+  uint8_t *_storage;
+  uint16_t _size;
+  uint8_t _dataStuckHigh;
+  uint8_t _dataStuckLow;
+  uint16_t _addressStuckHigh;
+  uint16_t _addressStuckLow;
+  uint16_t _stuckCellAddress[MAX_STUCK_CELLS];
+  uint8_t _stuckCellValue[MAX_STUCK_CELLS];
+  uint8_t _stuckCellCount;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef SRAMTRANSFERQUEUE_H
+#define SRAMTRANSFERQUEUE_H
+
+#include <Arduino.h>
+#include "HY62252A.h"
+
+struct SramTransfer;
+
+// Called when a transfer has completed.
+typedef void (*SramTransferCallback)(SramTransfer *transfer, void *context);
+
+/**
+ * Descriptor for one background transfer. Owned by the caller and must stay
+ * alive (and its buffer untouched) until done is set.
+ */
+struct SramTransfer
+{
+  uint16_t address;              // SRAM start address
+  uint8_t *buffer;               // MCU buffer to read into or write from
+  uint16_t length;               // Bytes to move
+  bool write;                    // true = MCU -> SRAM, false = SRAM -> MCU
+  SramTransferCallback callback; // Optional, called on completion
+  void *context;                 // Passed to the callback
+  volatile uint16_t transferred; // Progress so far
+  volatile bool done;            // Set when the whole transfer has completed
+};
+
+/**
+ * DMA-like background transfer engine for the HY62252A.
+ *
+ * Callers submit read or write descriptors and return immediately. Each
+ * poll() moves at most bytesPerTick bytes with a burst transfer, so large
+ * copies are spread over many loop iterations and things like
+ * AFMotorLegacyWrapper::updateSpeed() keep running on time.
+ *
+ * poll() can be called from loop() or from a timer ISR: it only uses the
+ * HY62252A block transfers, which neither log nor build Strings. A call that arrives
+ * while another poll() is still running is skipped. When poll() runs from an
+ * ISR, the main code must not use the HY62252A directly while the queue is
+ * busy, since the ISR may interrupt it in the middle of a bus cycle.
+ */
+class SramTransferQueue
+{
+public:
+  // Constructor. capacity is the maximum number of queued descriptors.
+  SramTransferQueue(HY62252A *sram, uint8_t capacity = 4, uint16_t bytesPerTick = 32);
+  ~SramTransferQueue();
+
+  // Queue a read of length bytes at address into buffer. False if the queue is full.
+  bool submitRead(SramTransfer *transfer, uint16_t address, uint8_t *buffer, uint16_t length,
+                  SramTransferCallback callback = nullptr, void *context = nullptr);
+
+  // Queue a write of length bytes from data to address. False if the queue is full.
+  bool submitWrite(SramTransfer *transfer, uint16_t address, const uint8_t *data, uint16_t length,
+                   SramTransferCallback callback = nullptr, void *context = nullptr);
+
+  // Move up to bytesPerTick bytes of the oldest transfer. Returns bytes moved.
+  uint16_t poll();
+
+  // Run poll() until the queue is empty.
+  void drain();
+
+  // Number of descriptors waiting or in progress.
+  uint8_t queueDepth() const { return _count; }
+
+  bool isIdle() const { return _count == 0; }
+
+  void setBytesPerTick(uint16_t bytesPerTick) { _bytesPerTick = bytesPerTick; }
+
+private:
+  bool submit(SramTransfer *transfer);
+
+  HY62252A *_sram;
+  SramTransfer **_queue;  // Ring of pending descriptors
+  uint8_t _capacity;
+  volatile uint8_t _head; // Next free slot
+  volatile uint8_t _tail; // Transfer in progress
+  volatile uint8_t _count;
+  uint16_t _bytesPerTick;
+  volatile bool _busy;    // Guards against re-entrant poll()
+};
+
+#endif
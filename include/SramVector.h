@@ -0,0 +1,124 @@
+#ifndef SRAMVECTOR_H
+#define SRAMVECTOR_H
+
+#include <Arduino.h>
+#include "HY62252A.h"
+#include "logger.h"
+
+/**
+ * Growable array of fixed-size elements stored in the HY62252A, inside a
+ * fixed SRAM region. The element count lives in MCU RAM; element data is
+ * moved with the chip's burst block transfers.
+ *
+ * T must be trivially copyable (plain structs, integers, floats).
+ */
+template <typename T>
+class SramVector
+{
+public:
+  /**
+   * @param sram The SRAM chip holding the elements.
+   * @param baseAddress First SRAM address used by the vector.
+   * @param capacity Maximum number of elements; uses capacity * sizeof(T) bytes.
+   *                 Clamped, with an error logged, if that runs past the end of the chip.
+   */
+  SramVector(HY62252A *sram, uint16_t baseAddress, uint16_t capacity)
+      : _sram(sram), _base(baseAddress), _capacity(capacity), _size(0)
+  {
+    uint32_t available = baseAddress < _sram->size() ? (_sram->size() - baseAddress) / sizeof(T) : 0;
+    if (capacity > available)
+    {
+      Logger::error("SramVector: capacity " + String(capacity) + " does not fit in SRAM, clamped to " + String(available));
+      _capacity = available;
+    }
+  }
+
+  // Append one element, false if the region is full.
+  bool push(const T &item)
+  {
+    return pushN(&item, 1) == 1;
+  }
+
+  // Append up to n elements with one burst write, returns how many fit.
+  uint16_t pushN(const T *items, uint16_t n)
+  {
+    if (n > _capacity - _size)
+    {
+      n = _capacity - _size;
+    }
+    _sram->writeBlock(addressOf(_size), (const uint8_t *)items, n * sizeof(T));
+    _size += n;
+    return n;
+  }
+
+  // Remove the last element, false if empty.
+  bool pop(T &item)
+  {
+    return popN(&item, 1) == 1;
+  }
+
+  // Remove up to n elements from the end, stored in their original order.
+  uint16_t popN(T *items, uint16_t n)
+  {
+    if (n > _size)
+    {
+      n = _size;
+    }
+    _size -= n;
+    _sram->readBlock(addressOf(_size), (uint8_t *)items, n * sizeof(T));
+    return n;
+  }
+
+  // Read the element at index, false if out of range.
+  bool get(uint16_t index, T &item)
+  {
+    return readN(index, &item, 1) == 1;
+  }
+
+  // Overwrite the element at index, false if out of range.
+  bool set(uint16_t index, const T &item)
+  {
+    if (index >= _size)
+    {
+      return false;
+    }
+    _sram->writeBlock(addressOf(index), (const uint8_t *)&item, sizeof(T));
+    return true;
+  }
+
+  // Read up to n elements starting at index with one burst read.
+  uint16_t readN(uint16_t index, T *items, uint16_t n)
+  {
+    if (index >= _size)
+    {
+      return 0;
+    }
+    if (n > _size - index)
+    {
+      n = _size - index;
+    }
+    _sram->readBlock(addressOf(index), (uint8_t *)items, n * sizeof(T));
+    return n;
+  }
+
+  // Drop everything (the SRAM contents are left as they are).
+  void clear() { _size = 0; }
+
+  uint16_t size() const { return _size; }
+  uint16_t capacity() const { return _capacity; }
+  bool empty() const { return _size == 0; }
+  bool full() const { return _size == _capacity; }
+
+private:
+  uint16_t addressOf(uint16_t index) const
+  {
+    return _base + index * sizeof(T);
+  }
+
+  HY62252A *_sram;
+  uint16_t _base;
+  uint16_t _capacity;
+  uint16_t _size;
+};
+
+#endif
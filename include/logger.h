@@ -45,9 +45,28 @@ public:
   static void trace(const String &message);
   static void ultra(const String &message);
 
+  // Same for plain strings, without building a String first.
+  static void log(LogLevel level, const char *message);
+  static void warning(const char *message);
+  static void error(const char *message);
+  static void info(const char *message);
+  static void trace(const char *message);
+  static void ultra(const char *message);
+
+  /**
+   * Log a label, a number and a suffix, e.g. ("Battery: ", 87, "%").
+   * The number is only formatted if the level is enabled, and never
+   * through a String.
+   */
+  static void log(LogLevel level, const char *label, int32_t value, const char *suffix = "");
+  static void log(LogLevel level, const char *label, float value, uint8_t decimals, const char *suffix = "");
+
   static void setLogLevel(LogLevel newLevel);
 
 private:
+  // Print the "[millis] LEVEL: " prefix. Returns false if the level is disabled.
+  static bool printPrefix(LogLevel level);
+
   static LogLevel currentLogLevel;
 };
 
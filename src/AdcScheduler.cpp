@@ -0,0 +1,254 @@
+#include "AdcScheduler.h"
+
+AdcScheduler::Channel AdcScheduler::_channels[ADC_SCHEDULER_MAX_CHANNELS];
+uint8_t AdcScheduler::_channelCount = 0;
+volatile uint8_t AdcScheduler::_current = 0;
+volatile uint8_t AdcScheduler::_selected = 0;
+volatile uint32_t AdcScheduler::_conversions = 0;
+bool AdcScheduler::_running = false;
+bool AdcScheduler::_pipelined = false;
+
+/**
+ * Adds a battery pack to the round-robin.
+ *
+ * @param manager The pack, sampled on its battery pin.
+ * @return false if the scheduler is running or full.
+ */
+bool AdcScheduler::attach(BatteryManager *manager)
+{
+  return manager && attachChannel(manager->getPin(), manager);
+}
+
+/**
+ * Adds an input that is only read with latest(), e.g. a current shunt,
+ * so it can be sampled without analogRead() while the scheduler runs.
+ *
+ * @param pin The analog pin.
+ * @return false if the scheduler is running or full.
+ */
+bool AdcScheduler::attachPin(uint8_t pin)
+{
+  return attachChannel(pin, nullptr);
+}
+
+int8_t AdcScheduler::channelOf(uint8_t pin)
+{
+  for (uint8_t i = 0; i < _channelCount; i++)
+  {
+    if (_channels[i].pin == pin)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool AdcScheduler::attachChannel(uint8_t pin, BatteryManager *manager)
+{
+  if (_running || _channelCount >= ADC_SCHEDULER_MAX_CHANNELS)
+  {
+    return false;
+  }
+  Channel &channel = _channels[_channelCount];
+  channel.manager = manager;
+  channel.pin = pin;
+#if defined(__AVR__)
+  // Same pin to channel mapping as analogRead()
+  if (pin >= A0)
+  {
+    pin -= A0;
+  }
+#if defined(analogPinToChannel)
+  pin = analogPinToChannel(pin);
+#endif
+#endif
+  channel.adcChannel = pin;
+  channel.head = 0;
+  channel.tail = 0;
+  channel.overruns = 0;
+  _channelCount++;
+  return true;
+}
+
+/**
+ * Seeds every channel with one blocking reading, so the levels and
+ * latest() are valid at once, then starts the conversions.
+ *
+ * @param mode FREE_RUNNING or TIMER0_OVERFLOW (AVR only, ignored elsewhere).
+ */
+void AdcScheduler::begin(TriggerMode mode)
+{
+  if (_running || _channelCount == 0)
+  {
+    return;
+  }
+  for (uint8_t i = 0; i < _channelCount; i++)
+  {
+    Channel &channel = _channels[i];
+    uint16_t value = analogRead(channel.pin);
+    // The slot latest() reads, not a reading for service()
+    channel.ring[(uint8_t)(channel.head - 1) & (ADC_SCHEDULER_RING - 1)] = value;
+    if (channel.manager)
+    {
+      channel.manager->seed(value);
+    }
+  }
+
+  _current = 0;
+  _selected = 0;
+  _running = true;
+#if defined(__AVR__)
+  // In free-running mode the next conversion has already started when the
+  // interrupt runs, so a new selection only applies to the one after it
+  _pipelined = mode == FREE_RUNNING;
+  selectChannel(0);
+  ADCSRB = (ADCSRB & ~((1 << ADTS2) | (1 << ADTS1) | (1 << ADTS0))) | (mode == TIMER0_OVERFLOW ? (1 << ADTS2) : 0);
+  ADCSRA |= (1 << ADATE) | (1 << ADIE) | (1 << ADIF); // Writing ADIF clears it
+  if (mode == FREE_RUNNING)
+  {
+    ADCSRA |= (1 << ADSC);
+  }
+#else
+  (void)mode;
+  _pipelined = false;
+#endif
+}
+
+void AdcScheduler::stop()
+{
+#if defined(__AVR__)
+  ADCSRA &= ~((1 << ADATE) | (1 << ADIE));
+  while (ADCSRA & (1 << ADSC))
+  {
+    // Let the last conversion finish before analogRead() takes over
+  }
+#endif
+  _running = false;
+}
+
+/**
+ * Moves the buffered readings into the packs' filters. Readings of plain
+ * inputs are dropped; latest() still returns the newest one.
+ *
+ * Without a conversion interrupt this first takes one reading of the next
+ * channel with analogRead().
+ *
+ * @return The number of readings fed.
+ */
+uint8_t AdcScheduler::service()
+{
+#if !defined(__AVR__)
+  if (_running)
+  {
+    onConversion(analogRead(_channels[_current].pin));
+  }
+#endif
+  uint8_t fed = 0;
+  for (uint8_t i = 0; i < _channelCount; i++)
+  {
+    Channel &channel = _channels[i];
+    uint8_t tail = channel.tail;
+    while (tail != channel.head)
+    {
+      uint16_t value = channel.ring[tail & (ADC_SCHEDULER_RING - 1)];
+      // Release the slot before the (slower) filter runs
+      channel.tail = ++tail;
+      if (channel.manager)
+      {
+        channel.manager->addSample(value);
+        fed++;
+      }
+    }
+  }
+  return fed;
+}
+
+/**
+ * Returns the most recent reading of a channel without consuming it.
+ *
+ * The slot before head is only rewritten after the ISR has gone round the
+ * whole ring, so it can be read without disabling interrupts.
+ */
+uint16_t AdcScheduler::latest(uint8_t index)
+{
+  if (index >= _channelCount)
+  {
+    return 0;
+  }
+  const Channel &channel = _channels[index];
+  return channel.ring[(uint8_t)(channel.head - 1) & (ADC_SCHEDULER_RING - 1)];
+}
+
+uint8_t AdcScheduler::available(uint8_t index)
+{
+  return index < _channelCount ? (uint8_t)(_channels[index].head - _channels[index].tail) : 0;
+}
+
+uint16_t AdcScheduler::getOverruns(uint8_t index)
+{
+  if (index >= _channelCount)
+  {
+    return 0;
+  }
+  noInterrupts();
+  uint16_t overruns = _channels[index].overruns;
+  interrupts();
+  return overruns;
+}
+
+uint32_t AdcScheduler::getConversions()
+{
+  noInterrupts();
+  uint32_t conversions = _conversions;
+  interrupts();
+  return conversions;
+}
+
+/**
+ * Stores a finished conversion in its channel's ring and selects the
+ * next channel. A full ring drops the reading: only service() may move
+ * the tail.
+ *
+ * @param value The 10-bit result.
+ */
+void AdcScheduler::onConversion(uint16_t value)
+{
+  Channel &channel = _channels[_current];
+  uint8_t head = channel.head;
+  if ((uint8_t)(head - channel.tail) >= ADC_SCHEDULER_RING)
+  {
+    channel.overruns++;
+  }
+  else
+  {
+    channel.ring[head & (ADC_SCHEDULER_RING - 1)] = value;
+    channel.head = head + 1;
+  }
+  _conversions++;
+
+  uint8_t next = _selected + 1 < _channelCount ? _selected + 1 : 0;
+  _current = _pipelined ? _selected : next;
+  _selected = next;
+  selectChannel(next);
+}
+
+void AdcScheduler::selectChannel(uint8_t index)
+{
+#if defined(__AVR__)
+  uint8_t adcChannel = _channels[index].adcChannel;
+#if defined(MUX5)
+  ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((adcChannel >> 3) & 0x01) << MUX5);
+#endif
+  // AVcc reference, as analogRead() uses by default
+  ADMUX = (DEFAULT << 6) | (adcChannel & 0x07);
+#else
+  (void)index;
+#endif
+}
+
+#if defined(__AVR__)
+ISR(ADC_vect)
+{
+  AdcScheduler::onConversion(ADC);
+}
+#endif
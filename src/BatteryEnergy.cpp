@@ -0,0 +1,320 @@
+#include "BatteryEnergy.h"
+#include "AdcScheduler.h"
+#include "Crc.h"
+#include "logger.h"
+
+// Longest interval integrated in one update; a longer gap (e.g. a stalled loop) is not extrapolated.
+static const uint32_t MAX_STEP_MILLIS = 60000;
+
+// At rest the count closes the gap to the voltage model by elapsed / this per update
+static const uint32_t BLEND_TIME_CONSTANT_MILLIS = 16000;
+
+// mA * ms per uAh
+static const uint32_t MILLIAMP_MILLIS_PER_MICROAMP_HOUR = 3600;
+
+// CRC seed of the SRAM record, so cleared (all zero) memory does not pass as a record
+static const uint8_t RECORD_CRC_INIT = 0x5A;
+
+/**
+ * Constructor. Uses the motor model until setShunt() is called.
+ *
+ * @param manager The pack whose voltage model the count is merged with.
+ * @param capacityMilliampHours Rated capacity of the pack in mAh.
+ */
+BatteryEnergy::BatteryEnergy(BatteryManager *manager, uint32_t capacityMilliampHours)
+    : _manager(manager), _capacity(capacityMilliampHours * 1000), _shuntPin(-1), _shuntZero(0),
+      _shuntMicroampsPerCount(0), _idleMilliamps(0), _fullSpeedMilliamps(0), _motorDuty(0),
+      _restMilliamps(50), _minimumRest(30000), _resting(false), _restingSince(0), _store(nullptr), _storeKey(0), _sram(nullptr), _sramAddress(0),
+      _checkpointInterval(60000), _checkpointStep(_capacity / 100), _lastCheckpoint(0),
+      _checkpointRemaining(0), _checkpoints(0), _lastUpdate(0), _remainder(0), _remaining(0),
+      _throughput(0), _cycles(0), _milliamps(0), _averageCurrent(0), _runtimeMinutes(0xFFFF)
+{
+}
+
+/**
+ * Measures the pack current with a shunt amplifier on an analog pin.
+ *
+ * @param pin The analog pin.
+ * @param zeroCounts Reading at zero current (readings below it mean charging).
+ * @param microampsPerCount Current per ADC count.
+ */
+void BatteryEnergy::setShunt(int pin, uint16_t zeroCounts, uint32_t microampsPerCount)
+{
+  _shuntPin = pin;
+  _shuntZero = zeroCounts;
+  _shuntMicroampsPerCount = microampsPerCount;
+}
+
+/**
+ * Estimates the pack current from the motor duty: idle + full * duty / 255.
+ *
+ * @param idleMilliamps Current with the motors stopped (MCU, LCD...).
+ * @param fullSpeedMilliamps Additional current at full duty.
+ */
+void BatteryEnergy::setMotorModel(uint16_t idleMilliamps, uint16_t fullSpeedMilliamps)
+{
+  _shuntPin = -1;
+  _idleMilliamps = idleMilliamps;
+  _fullSpeedMilliamps = fullSpeedMilliamps;
+}
+
+void BatteryEnergy::checkpointTo(EepromKvStore *store, uint8_t key)
+{
+  _store = store;
+  _storeKey = key;
+  _sram = nullptr;
+}
+
+void BatteryEnergy::checkpointTo(SramDevice *sram, uint16_t address)
+{
+  _sram = sram;
+  _sramAddress = address;
+  _store = nullptr;
+}
+
+void BatteryEnergy::setCheckpointThrottle(uint32_t intervalMillis, uint32_t stepMicroampHours)
+{
+  _checkpointInterval = intervalMillis;
+  _checkpointStep = stepMicroampHours;
+}
+
+/**
+ * Restores the last checkpoint. Without one the remaining charge starts at
+ * the voltage model's state of charge, which needs the pack to be sampled
+ * (BatteryManager::seed() or poll()) before.
+ *
+ * @return true if a checkpoint was restored.
+ */
+bool BatteryEnergy::begin()
+{
+  bool restored = loadRecord();
+  if (!restored)
+  {
+    _remaining = (uint32_t)((uint64_t)_capacity * _manager->getStateOfCharge() / 1000);
+    _throughput = 0;
+    _cycles = 0;
+    Logger::log(INFO, "No energy checkpoint, starting at ", (int32_t)(_remaining / 1000), " mAh");
+  }
+  else
+  {
+    Logger::log(INFO, "Energy restored: ", (int32_t)(_remaining / 1000), " mAh");
+  }
+  _checkpointRemaining = _remaining;
+  _lastCheckpoint = millis();
+  _lastUpdate = millis();
+  _remainder = 0;
+  _resting = false;
+  return restored;
+}
+
+/**
+ * Integrates the current since the last call, merges the count with the
+ * voltage model at rest, updates the runtime prediction and saves a
+ * checkpoint when the throttle allows it.
+ */
+void BatteryEnergy::update()
+{
+  unsigned long now = millis();
+  uint32_t elapsed = now - _lastUpdate;
+  _lastUpdate = now;
+  if (elapsed > MAX_STEP_MILLIS)
+  {
+    elapsed = MAX_STEP_MILLIS;
+  }
+
+  _milliamps = measure();
+  _manager->setLoadCurrent(_milliamps <= 0 ? 0 : _milliamps < 0xFFFF ? _milliamps : 0xFFFF);
+
+  // Signed, so a remainder left by discharging is cancelled by charging and vice versa
+  _remainder += _milliamps * (int32_t)elapsed;
+  int32_t microampHours = _remainder / (int32_t)MILLIAMP_MILLIS_PER_MICROAMP_HOUR;
+  _remainder -= microampHours * (int32_t)MILLIAMP_MILLIS_PER_MICROAMP_HOUR;
+
+  if (microampHours >= 0)
+  {
+    _remaining = (uint32_t)microampHours < _remaining ? _remaining - microampHours : 0;
+    _throughput += microampHours;
+    while (_capacity > 0 && _throughput >= _capacity)
+    {
+      _throughput -= _capacity;
+      _cycles++;
+    }
+  }
+  else
+  {
+    _remaining += -microampHours;
+    if (_remaining > _capacity)
+    {
+      _remaining = _capacity;
+    }
+  }
+
+  if (_milliamps < _restMilliamps && _milliamps > -(int32_t)_restMilliamps)
+  {
+    if (!_resting)
+    {
+      _resting = true;
+      _restingSince = now;
+    }
+    // Only the part of the interval after the minimum rest counts
+    uint32_t rested = now - _restingSince;
+    if (rested > _minimumRest)
+    {
+      blendWithVoltage(rested - _minimumRest < elapsed ? rested - _minimumRest : elapsed);
+    }
+  }
+  else
+  {
+    _resting = false;
+  }
+
+  // EMA with 4 fractional bits, weight 1/8
+  _averageCurrent += (_milliamps * 16 - _averageCurrent) / 8;
+  if (_averageCurrent > 16)
+  {
+    // 1 uAh at 1 mA lasts 3.6 s, so minutes = uAh * 0.06 / mA = uAh * 16 * 6 / (average * 100)
+    uint32_t minutes = (uint32_t)((uint64_t)_remaining * 96 / ((uint32_t)_averageCurrent * 100));
+    _runtimeMinutes = minutes < 0xFFFF ? minutes : 0xFFFF;
+  }
+  else
+  {
+    _runtimeMinutes = 0xFFFF;
+  }
+
+  uint32_t moved = _remaining > _checkpointRemaining ? _remaining - _checkpointRemaining : _checkpointRemaining - _remaining;
+  if (now - _lastCheckpoint >= _checkpointInterval && moved >= _checkpointStep)
+  {
+    checkpoint();
+  }
+}
+
+/**
+ * Saves the state now, regardless of the throttle.
+ *
+ * @return false if no checkpoint target is set or the write failed.
+ */
+bool BatteryEnergy::checkpoint()
+{
+  if (!saveRecord())
+  {
+    return false;
+  }
+  _checkpointRemaining = _remaining;
+  _lastCheckpoint = millis();
+  _checkpoints++;
+  return true;
+}
+
+uint16_t BatteryEnergy::getStateOfCharge() const
+{
+  if (_capacity == 0)
+  {
+    return 0;
+  }
+  return (uint16_t)((uint64_t)_remaining * 1000 / _capacity);
+}
+
+/**
+ * Reads the shunt, through AdcScheduler while it runs (analogRead() is not
+ * allowed then), or evaluates the motor model.
+ */
+int32_t BatteryEnergy::measure()
+{
+  if (_shuntPin >= 0)
+  {
+    int32_t reading;
+    if (AdcScheduler::isRunning())
+    {
+      int8_t channel = AdcScheduler::channelOf(_shuntPin);
+      if (channel < 0)
+      {
+        // Not attached: there is no reading to take, fall back to the model
+        return _idleMilliamps + (int32_t)_fullSpeedMilliamps * _motorDuty / 255;
+      }
+      reading = AdcScheduler::latest(channel);
+    }
+    else
+    {
+      reading = analogRead(_shuntPin);
+    }
+    int32_t counts = reading - _shuntZero;
+    return counts * (int32_t)_shuntMicroampsPerCount / 1000;
+  }
+  return _idleMilliamps + (int32_t)_fullSpeedMilliamps * _motorDuty / 255;
+}
+
+/**
+ * Moves the count towards the voltage model's estimate by a share that
+ * grows with the time covered, so the rate does not depend on how often
+ * update() runs. Only called after the minimum rest, once the terminal
+ * voltage has relaxed to the open-circuit voltage.
+ *
+ * @param elapsed Rest time covered by this call in ms.
+ */
+void BatteryEnergy::blendWithVoltage(uint32_t elapsed)
+{
+  if (!_manager->hasReading())
+  {
+    return;
+  }
+  int32_t target = (int32_t)((uint64_t)_capacity * _manager->getStateOfCharge() / 1000);
+  if (elapsed > BLEND_TIME_CONSTANT_MILLIS)
+  {
+    elapsed = BLEND_TIME_CONSTANT_MILLIS;
+  }
+  _remaining += (int32_t)((int64_t)(target - (int32_t)_remaining) * elapsed / BLEND_TIME_CONSTANT_MILLIS);
+}
+
+bool BatteryEnergy::saveRecord()
+{
+  Record record = {_remaining, _throughput, _cycles};
+  if (_store)
+  {
+    if (!_store->put(_storeKey, record))
+    {
+      Logger::error("Energy checkpoint failed");
+      return false;
+    }
+    return true;
+  }
+  if (_sram)
+  {
+    _sram->writeBlock(_sramAddress, (const uint8_t *)&record, sizeof(record));
+    _sram->writeByte(_sramAddress + sizeof(record), Crc::crc8((const uint8_t *)&record, sizeof(record), RECORD_CRC_INIT));
+    return true;
+  }
+  return false;
+}
+
+bool BatteryEnergy::loadRecord()
+{
+  Record record;
+  if (_store)
+  {
+    if (!_store->get(_storeKey, record))
+    {
+      return false;
+    }
+  }
+  else if (_sram)
+  {
+    _sram->readBlock(_sramAddress, (uint8_t *)&record, sizeof(record));
+    if (_sram->readByte(_sramAddress + sizeof(record)) != Crc::crc8((const uint8_t *)&record, sizeof(record), RECORD_CRC_INIT))
+    {
+      return false;
+    }
+  }
+  else
+  {
+    return false;
+  }
+  if (record.remaining > _capacity)
+  {
+    Logger::warning("Energy checkpoint exceeds the capacity, ignored");
+    return false;
+  }
+  _remaining = record.remaining;
+  _throughput = record.throughput;
+  _cycles = record.cycles;
+  return true;
+}
@@ -10,90 +10,258 @@ BatteryManager::BatteryManager(int batteryPin, int batteryThreshold, int amountO
     : batteryPin(batteryPin), batteryThreshold(batteryThreshold), amountOfBatteries(amountOfBatteries), theoreticalMaxVoltage(theoreticalMaxVoltage)
 {
   Logger::log(INFO, "Battery manager initialized");
+  // Below batteryThreshold has always been where the warnings start
+  thresholds.warningThreshold = batteryThreshold;
 }
 
 BatteryManager::BatteryManager(int batteryPin)
     : batteryPin(batteryPin)
 {
   Logger::log(INFO, "Battery manager initialized");
-  theoreticalMaxVoltage = 4.2;
   amountOfBatteries = 2;
+  // Full scale is the pack voltage: 4.2 V per cell in series
+  theoreticalMaxVoltage = 4.2f * amountOfBatteries;
   batteryThreshold = 25;
 }
 
+/**
+ * Get the battery level from the filtered voltage.
+ * Before the first tick() this takes a single blocking reading to start the filter.
+ *
+ * @return The battery percentage
+ */
 float BatteryManager::getBatteryAdjustedLevel()
 {
-  currentVoltage = analogRead(batteryPin) * (theoreticalMaxVoltage / 1023.0);
-  float batteryPercent = getBatteryPercentage();
-
-  if (batteryPercent < batteryThreshold)
+  if (!hasReading())
   {
-    Logger::log(WARNING, "Battery level is " + String(batteryPercent) + " belov given threshold: " + String(batteryPercent) + "%");
+    seed(analogRead(batteryPin));
   }
-  return batteryPercent;
+  return cachedPercentage;
 }
 
+// Open-circuit voltage of one 18650 cell in mV at 0%, 10%, ... 100% charge,
+// through the points listed in BatteryManager.h
+static const uint16_t OCV_CURVE[] PROGMEM = {3000, 3350, 3460, 3540, 3620, 3700, 3790, 3880, 3960, 4050, 4200};
+
+// Per segment: tenths of a percent per mV, times 256, so interpolating needs no division
+#define OCV_SLOPE(from, to) ((100UL * 256 + ((to) - (from)) / 2) / ((to) - (from)))
+static const uint16_t OCV_SLOPES[] PROGMEM = {
+    OCV_SLOPE(3000, 3350), OCV_SLOPE(3350, 3460), OCV_SLOPE(3460, 3540), OCV_SLOPE(3540, 3620), OCV_SLOPE(3620, 3700),
+    OCV_SLOPE(3700, 3790), OCV_SLOPE(3790, 3880), OCV_SLOPE(3880, 3960), OCV_SLOPE(3960, 4050), OCV_SLOPE(4050, 4200)};
+
+static const uint8_t OCV_POINTS = sizeof(OCV_CURVE) / sizeof(OCV_CURVE[0]);
+
 /**
- * Get the battery voltage
- * 4.2V: 100% (Fully charged)
- * 4.0V: ~85% charge
- * 3.7V: ~50% charge
- * 3.5V: ~25% charge
- * 3.2V: ~0-5% charge (Considered nearly empty)
- * <3.0V: Risk of damaging the battery if further discharged
+ * Get the battery percentage from the filtered pack voltage.
  *
- * @return The "real" battery percentage
+ * The pack voltage is split over amountOfBatteries cells in series, the
+ * voltage lost over the internal resistance at the current load is added
+ * back, and the open-circuit voltage curve gives the charge.
+ *
+ * @return The battery percentage
  */
 float BatteryManager::getBatteryPercentage()
 {
-  int linearBatteryPercentage = 0;
+  uint16_t cells = amountOfBatteries > 0 ? amountOfBatteries : 1;
+  uint16_t cellMillivolts = filteredMillivolts / cells;
+  cellMillivolts += (uint32_t)loadMilliamps * internalMilliohms / 1000;
+  this->cellMillivolts = cellMillivolts;
+  stateOfCharge = stateOfChargeFromCell(cellMillivolts);
+  return stateOfCharge / 10.0f;
+}
 
-  switch (static_cast<int>(currentVoltage * 10))
+/**
+ * Interpolate the open-circuit voltage curve.
+ *
+ * A binary search over the 11 points and one 16-bit multiply.
+ * The result only grows with the voltage and is clamped to 0-1000.
+ *
+ * @param cellMillivolts Open-circuit voltage of one cell
+ * @return The state of charge in tenths of a percent
+ */
+uint16_t BatteryManager::stateOfChargeFromCell(uint16_t cellMillivolts)
+{
+  if (cellMillivolts <= pgm_read_word(&OCV_CURVE[0]))
   {
-  case 84 ... 100:
-    linearBatteryPercentage = 100;
-    break;
-  case 80 ... 83:
-    linearBatteryPercentage = 85;
-    break;
-  case 74 ... 79:
-    linearBatteryPercentage = 50;
-    break;
-  case 70 ... 73:
-    linearBatteryPercentage = 25;
-    break;
-  case 64 ... 69:
-    linearBatteryPercentage = 10;
-    break;
+    return 0;
   }
+  if (cellMillivolts >= pgm_read_word(&OCV_CURVE[OCV_POINTS - 1]))
+  {
+    return 1000;
+  }
+  // Find the segment [low, low + 1] holding the voltage
+  uint8_t low = 0;
+  uint8_t high = OCV_POINTS - 1;
+  while (high - low > 1)
+  {
+    uint8_t middle = (low + high) / 2;
+    if (cellMillivolts < pgm_read_word(&OCV_CURVE[middle]))
+    {
+      high = middle;
+    }
+    else
+    {
+      low = middle;
+    }
+  }
+  // At most ~100 x 256, fits in 16 bits
+  uint16_t scaled = (cellMillivolts - pgm_read_word(&OCV_CURVE[low])) * pgm_read_word(&OCV_SLOPES[low]);
+  return low * 100 + (scaled >> 8);
+}
 
-  float a = 10.91;
-  float b = -174.11;
-  float c = 662.43;
-
-  int algoritmicBatteryPercentage = static_cast<int>(a * currentVoltage * currentVoltage + b * currentVoltage + c);
+void BatteryManager::setInternalResistance(uint16_t milliohmsPerCell)
+{
+  internalMilliohms = milliohmsPerCell;
+}
 
-  // Ensure the result is clamped between 0% and 100%
-  if (algoritmicBatteryPercentage > 100)
-    algoritmicBatteryPercentage = 100;
-  if (algoritmicBatteryPercentage < 0)
-    algoritmicBatteryPercentage = 0;
+void BatteryManager::setLoadCurrent(uint16_t milliamps)
+{
+  loadMilliamps = milliamps;
+}
 
-  Logger::log(INFO, "linearBatteryPercentage: " + String(linearBatteryPercentage));
-  Logger::log(INFO, "algoritmicBatteryPercentage: " + String(algoritmicBatteryPercentage));
-  // no surprise here, the linearBatteryPercentage is always going to be the one we can trust, maybe
-  return linearBatteryPercentage;
+/**
+ * Estimate the load current from a motor speed.
+ *
+ * @param speed Motor speed, 0-255 as given to the motor driver
+ * @param fullSpeedMilliamps Current drawn at full speed
+ */
+void BatteryManager::setLoadFromSpeed(uint8_t speed, uint16_t fullSpeedMilliamps)
+{
+  loadMilliamps = (uint32_t)speed * fullSpeedMilliamps / 255;
 }
 
+/**
+ * Whether the debounced state is critical or worse.
+ * Uses the last filtered sample; only reads the ADC if there is none yet.
+ */
 bool BatteryManager::isBatteryCritical()
 {
-  float batteryPercent = getBatteryAdjustedLevel();
-  if (batteryPercent < 10)
+  if (!hasReading())
+  {
+    getBatteryAdjustedLevel();
+  }
+  return batteryState >= BATTERY_CRITICAL;
+}
+
+/**
+ * Register a callback for state changes.
+ *
+ * @param callback Called with the new and the previous state
+ * @param context Passed to the callback
+ * @return false if BATTERY_MAX_CALLBACKS are registered already
+ */
+bool BatteryManager::addEventCallback(BatteryEventCallback callback, void *context)
+{
+  if (!callback || eventCallbackCount >= BATTERY_MAX_CALLBACKS)
+  {
+    return false;
+  }
+  eventCallbacks[eventCallbackCount].callback = callback;
+  eventCallbacks[eventCallbackCount].context = context;
+  eventCallbackCount++;
+  return true;
+}
+
+/**
+ * Set how far the level must rise above a threshold before the state improves.
+ *
+ * @param tenthsOfPercent Hysteresis band, e.g. 20 for 2%
+ */
+void BatteryManager::setHysteresis(uint16_t tenthsOfPercent)
+{
+  hysteresis = tenthsOfPercent;
+}
+
+/**
+ * Set how long a new state must hold before it is reported.
+ *
+ * @param debounceMillis Time in milliseconds, 0 to report at once
+ */
+void BatteryManager::setDebounce(uint32_t debounceMillis)
+{
+  this->debounceMillis = debounceMillis;
+}
+
+/**
+ * The state a level falls in, without hysteresis.
+ *
+ * @param level State of charge in tenths of a percent
+ */
+BatteryState BatteryManager::classify(int32_t level) const
+{
+  if (level < thresholds.shutdownThreshold * 10L)
+  {
+    return BATTERY_SHUTDOWN;
+  }
+  if (level < thresholds.criticalThreshold * 10L)
+  {
+    return BATTERY_CRITICAL;
+  }
+  if (level < thresholds.warningThreshold * 10L)
+  {
+    return BATTERY_WARNING;
+  }
+  return BATTERY_OK;
+}
+
+/**
+ * Update the state from the latest filtered sample.
+ *
+ * Getting worse only needs the level below a threshold; getting better
+ * needs it above the threshold plus the hysteresis band. Either way the
+ * new state must hold for the debounce time before the callbacks run.
+ */
+void BatteryManager::evaluateThresholds()
+{
+  BatteryState candidate = classify(stateOfCharge);
+  if (candidate < batteryState)
+  {
+    candidate = classify((int32_t)stateOfCharge - hysteresis);
+    if (candidate > batteryState)
+    {
+      candidate = batteryState;
+    }
+  }
+
+  if (candidate == batteryState)
+  {
+    pendingState = batteryState;
+    return;
+  }
+  if (candidate != pendingState)
+  {
+    pendingState = candidate;
+    pendingSince = millis();
+  }
+  if (millis() - pendingSince < debounceMillis)
+  {
+    return;
+  }
+
+  changeState(candidate);
+}
+
+/**
+ * Switch to a new state, log it and run the callbacks.
+ *
+ * @param state The new state
+ */
+void BatteryManager::changeState(BatteryState state)
+{
+  BatteryState previous = batteryState;
+  batteryState = state;
+  pendingState = state;
+  if (state == previous)
   {
-    Logger::log(INFO, "Battery level is critical: " + String(batteryPercent) + "%");
-    return true;
+    return;
+  }
+  static const char *const labels[] = {"Battery ok, level ", "Battery warning, level ", "Battery critical, level ",
+                                       "Battery shutdown, level "};
+  Logger::log(batteryState > previous ? WARNING : INFO, labels[batteryState], stateOfCharge / 10.0f, 1, "%");
+  for (uint8_t i = 0; i < eventCallbackCount; i++)
+  {
+    eventCallbacks[i].callback(this, batteryState, previous, eventCallbacks[i].context);
   }
-  return false;
 }
 
 void BatteryManager::setBatteryThresholds(int warningThreshold, int criticalThreshold, int shutdownThreshold)
@@ -105,3 +273,129 @@ void BatteryManager::setBatteryThresholds(int warningThreshold, int criticalThre
   if (shutdownThreshold != -1)
     thresholds.shutdownThreshold = shutdownThreshold;
 }
+
+void BatteryManager::configureSampling(uint8_t extraBits, uint8_t medianWindow, uint8_t emaShift, uint32_t sampleIntervalMicros)
+{
+  this->extraBits = extraBits > 4 ? 4 : extraBits;
+  this->medianWindow = medianWindow < 1 ? 1 : (medianWindow > BATTERY_MEDIAN_MAX ? BATTERY_MEDIAN_MAX : medianWindow);
+  this->emaShift = emaShift > 8 ? 8 : emaShift;
+  this->sampleIntervalMicros = sampleIntervalMicros;
+  oversampleSum = 0;
+  oversampleCount = 0;
+  medianIndex = 0;
+  medianFill = 0;
+  filteredSamples = 0;
+}
+
+/**
+ * Start every filter stage at one reading instead of ramping up from 0.
+ * The state is set from this reading at once, without hysteresis or
+ * debounce, and the callbacks hear about it if it is not ok.
+ *
+ * @param raw A 10-bit ADC reading
+ */
+void BatteryManager::seed(uint16_t raw)
+{
+  oversampleSum = 0;
+  oversampleCount = 0;
+  for (uint8_t i = 0; i < medianWindow; i++)
+  {
+    medianRing[i] = raw << extraBits;
+  }
+  medianIndex = 0;
+  medianFill = medianWindow;
+  emaState = (uint32_t)raw << (extraBits + emaShift);
+  filteredSamples = 1;
+  updateLevel(raw << extraBits);
+  // The first reading is the state, not a change to debounce
+  changeState(classify(stateOfCharge));
+}
+
+bool BatteryManager::tick()
+{
+  return addSample(analogRead(batteryPin));
+}
+
+bool BatteryManager::poll()
+{
+  if (micros() - lastSampleMicros < sampleIntervalMicros)
+  {
+    return false;
+  }
+  lastSampleMicros = micros();
+  return tick();
+}
+
+/**
+ * Run one raw reading through the pipeline:
+ * oversampling and decimation, median-of-k, then the EMA.
+ *
+ * @param raw A 10-bit ADC reading
+ * @return true if the reading completed a filtered sample
+ */
+bool BatteryManager::addSample(uint16_t raw)
+{
+  oversampleSum += raw;
+  if (++oversampleCount < (1 << (2 * extraBits)))
+  {
+    return false;
+  }
+  // 4^b readings summed, shifted by b: a (10 + b)-bit sample
+  uint16_t sample = oversampleSum >> extraBits;
+  oversampleSum = 0;
+  oversampleCount = 0;
+
+  medianRing[medianIndex] = sample;
+  medianIndex = (medianIndex + 1) % medianWindow;
+  if (medianFill < medianWindow)
+  {
+    medianFill++;
+  }
+  uint16_t value = median();
+
+  // emaState holds the output with emaShift fractional bits, so small steps are not lost
+  if (filteredSamples == 0)
+  {
+    emaState = (uint32_t)value << emaShift;
+  }
+  else
+  {
+    emaState = emaState - (emaState >> emaShift) + value;
+  }
+  filteredSamples++;
+  updateLevel(emaState >> emaShift);
+  return true;
+}
+
+uint16_t BatteryManager::median() const
+{
+  uint16_t sorted[BATTERY_MEDIAN_MAX];
+  for (uint8_t i = 0; i < medianFill; i++)
+  {
+    // Insertion sort, the window is at most 5 values
+    uint16_t value = medianRing[i];
+    uint8_t j = i;
+    while (j > 0 && sorted[j - 1] > value)
+    {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = value;
+  }
+  return sorted[medianFill / 2];
+}
+
+/**
+ * Convert a filtered sample to millivolts and refresh the cached level.
+ * ADC full scale is theoreticalMaxVoltage, the voltage of the whole pack.
+ *
+ * @param filtered Filtered ADC value with extraBits fractional bits
+ */
+void BatteryManager::updateLevel(uint16_t filtered)
+{
+  uint32_t fullScaleMillivolts = (uint32_t)(theoreticalMaxVoltage * 1000 + 0.5f);
+  filteredMillivolts = (uint32_t)filtered * fullScaleMillivolts / (1023UL << extraBits);
+  currentVoltage = filteredMillivolts / 1000.0f;
+  cachedPercentage = getBatteryPercentage();
+  evaluateThresholds();
+}
@@ -1,14 +1,5 @@
-// Need to comment this out due to arduino, for now.
-// I'm sorry...
-#ifdef ESP8266
-
 #include "EEPROM24LC32A.h"
-#ifdef ESP8266
-#include <algorithm>
-// NodeMCU-specific code
-#elif defined(ARDUINO)
-#include <Arduino.h>
-#endif
+
 /**
  * @brief Constructor for the EEPROM24LC32A class.
  *
@@ -19,10 +10,18 @@
  * @param deviceAddress The I2C address of the EEPROM. Default is 0x50.
  */
 EEPROM24LC32A::EEPROM24LC32A(uint8_t deviceAddress)
-    : _deviceAddress(deviceAddress)
+    : _cache(nullptr), _cachePages(0), _cacheClock(0), _skipUnchanged(false),
+      _cacheHits(0), _cacheMisses(0), _skippedWrites(0),
+      _asyncHead(0), _asyncCount(0), _asyncWaiting(false), _asyncStarted(0), _asyncSent(0), _writeTimeoutMs(10),
+      _asyncInFlight(false),
+      _deviceAddress(deviceAddress), _writeCombining(false), _pendingPage(0), _pendingMask(0)
+{
+  // Wire is started by I2cBus::begin() (or on the first transaction), not here
+}
+
+EEPROM24LC32A::~EEPROM24LC32A()
 {
-  // Initialize the I2C communication
-  Wire.begin();
+  delete[] _cache;
 }
 
 /**
@@ -38,23 +37,24 @@ EEPROM24LC32A::EEPROM24LC32A(uint8_t deviceAddress)
  */
 bool EEPROM24LC32A::writeByte(uint16_t memoryAddress, uint8_t data)
 {
-  // Begin I2C transmission to the EEPROM device
-  Wire.beginTransmission(_deviceAddress);
-  // Send the most significant byte (MSB) of the memory address
-  Wire.write((memoryAddress >> 8) & 0xFF);
-  // Send the least significant byte (LSB) of the memory address
-  Wire.write(memoryAddress & 0xFF);
-  // Send the data byte to be written to the EEPROM
-  Wire.write(data);
-  // End the transmission and check if it was successful
-  if (Wire.endTransmission() != 0)
+  if (_writeCombining)
   {
-    return false; // Return false if there was an error
+    uint16_t page = memoryAddress & ~(uint16_t)(PAGE_SIZE - 1);
+    // A byte for another page pushes the buffered one out first
+    if (_pendingMask != 0 && page != _pendingPage && !flush())
+    {
+      return false;
+    }
+    _pendingPage = page;
+    _pendingData[memoryAddress & (PAGE_SIZE - 1)] = data;
+    _pendingMask |= (uint32_t)1 << (memoryAddress & (PAGE_SIZE - 1));
+    return true;
   }
 
-  // Wait for the EEPROM to complete the write operation
-  _waitForWrite();
-  return true; // Return true if the write was successful
+  _drainAsync();
+
+  // A single byte is a one-byte page write
+  return _writePage(memoryAddress, &data, 1);
 }
 
 /**
@@ -67,34 +67,37 @@ bool EEPROM24LC32A::writeByte(uint16_t memoryAddress, uint8_t data)
  */
 uint8_t EEPROM24LC32A::readByte(uint16_t memoryAddress)
 {
-  // Begin I2C transmission to the EEPROM device
-  Wire.beginTransmission(_deviceAddress);
-  // Send the most significant byte (MSB) of the memory address
-  Wire.write((memoryAddress >> 8) & 0xFF);
-  // Send the least significant byte (LSB) of the memory address
-  Wire.write(memoryAddress & 0xFF);
-  // End the transmission and check if it was successful
-  if (Wire.endTransmission() != 0)
+  // Bytes still waiting in the write-combining buffer are newer than the EEPROM
+  if (_pendingMask != 0 && (memoryAddress & ~(uint16_t)(PAGE_SIZE - 1)) == _pendingPage &&
+      ((_pendingMask >> (memoryAddress & (PAGE_SIZE - 1))) & 1))
   {
-    return 0; // Return 0 if there was an error
+    return _pendingData[memoryAddress & (PAGE_SIZE - 1)];
   }
 
-  // Request 1 byte of data from the EEPROM
-  Wire.requestFrom(_deviceAddress, (uint8_t)1);
-  // If data is available, read and return it
-  if (Wire.available())
+  _drainAsync();
+
+  if (_cache)
   {
-    return Wire.read();
+    uint8_t value = 0;
+    _readCached(memoryAddress, &value, 1);
+    return value;
   }
 
-  return 0; // Return 0 if no data was available
+  // Set the address, then read one byte from it
+  uint8_t value = 0;
+  if (!_setReadAddress(memoryAddress) || !_readNext(&value, 1))
+  {
+    return 0; // Return 0 if there was an error
+  }
+  return value;
 }
 
 /**
  * @brief Writes multiple bytes to the EEPROM starting from a specific address.
  *
- * This function writes a sequence of bytes to the EEPROM. Writing multiple
- * bytes at once can be more efficient than writing individual bytes.
+ * This function writes a sequence of bytes to the EEPROM. The data is split
+ * at the 32-byte page boundaries so that no page write wraps around inside
+ * a page, and every page write is as full as the Wire buffer allows.
  *
  * @param memoryAddress The starting address in the EEPROM where the data will be written.
  * @param data A pointer to the array of data to be written.
@@ -103,29 +106,27 @@ uint8_t EEPROM24LC32A::readByte(uint16_t memoryAddress)
  */
 bool EEPROM24LC32A::writeBytes(uint16_t memoryAddress, const uint8_t *data, size_t length)
 {
-  // Write data in chunks that fit within the I2C transmission limit
-  while (length > 0)
+  _drainAsync();
+
+  // Keep the order of writes: anything buffered goes out first
+  if (!flush())
   {
-    // Begin I2C transmission to the EEPROM device
-    Wire.beginTransmission(_deviceAddress);
-    // Send the most significant byte (MSB) of the memory address
-    Wire.write((memoryAddress >> 8) & 0xFF);
-    // Send the least significant byte (LSB) of the memory address
-    Wire.write(memoryAddress & 0xFF);
+    return false;
+  }
 
-    // Determine the number of bytes to write in this chunk (maximum 30 bytes)
-    size_t bytesToWrite = std::min(length, (size_t)30);
-    // Write the chunk of data
-    Wire.write(data, bytesToWrite);
-    // End the transmission and check if it was successful
-    if (Wire.endTransmission() != 0)
+  while (length > 0)
+  {
+    // Never cross a page boundary, the chip would wrap around inside the page
+    size_t bytesToWrite = PAGE_SIZE - (memoryAddress & (PAGE_SIZE - 1));
+    if (bytesToWrite > length)
+    {
+      bytesToWrite = length;
+    }
+    if (!_writePage(memoryAddress, data, bytesToWrite))
     {
       return false; // Return false if there was an error
     }
 
-    // Wait for the EEPROM to complete the write operation
-    _waitForWrite();
-
     // Update the memory address, data pointer, and remaining length
     memoryAddress += bytesToWrite;
     data += bytesToWrite;
@@ -147,38 +148,280 @@ bool EEPROM24LC32A::writeBytes(uint16_t memoryAddress, const uint8_t *data, size
  */
 bool EEPROM24LC32A::readBytes(uint16_t memoryAddress, uint8_t *buffer, size_t length)
 {
-  // Read data in chunks that fit within the I2C transmission limit
+  _drainAsync();
+
+  bool ok = _cache ? _readCached(memoryAddress, buffer, length) : _readRaw(memoryAddress, buffer, length);
+  _overlayPending(memoryAddress, buffer, length);
+  return ok;
+}
+
+/**
+ * @brief Reads straight from the chip, in chunks that fit the Wire buffer.
+ *
+ * @param memoryAddress The starting address.
+ * @param buffer Buffer for the data.
+ * @param length The number of bytes to read.
+ * @return true if the read was successful, false otherwise.
+ */
+bool EEPROM24LC32A::_readRaw(uint16_t memoryAddress, uint8_t *buffer, size_t length)
+{
+  // The address is sent once, the chip's address counter does the rest
+  if (!_setReadAddress(memoryAddress))
+  {
+    return false;
+  }
+
+  // Read data in chunks that fit within the Wire receive buffer
   while (length > 0)
   {
-    // Begin I2C transmission to the EEPROM device
-    Wire.beginTransmission(_deviceAddress);
-    // Send the most significant byte (MSB) of the memory address
-    Wire.write((memoryAddress >> 8) & 0xFF);
-    // Send the least significant byte (LSB) of the memory address
-    Wire.write(memoryAddress & 0xFF);
-    // End the transmission and check if it was successful
-    if (Wire.endTransmission() != 0)
+    size_t bytesToRead = length < EEPROM24LC32A_WIRE_BUFFER ? length : EEPROM24LC32A_WIRE_BUFFER;
+    if (!_readNext(buffer, bytesToRead))
     {
-      return false; // Return false if there was an error
+      return false;
     }
+    buffer += bytesToRead;
+    length -= bytesToRead;
+  }
 
-    // Determine the number of bytes to read in this chunk (maximum 32 bytes)
-    size_t bytesToRead = std::min(length, (size_t)32);
-    // Request the chunk of data from the EEPROM
-    Wire.requestFrom(_deviceAddress, (uint8_t)bytesToRead);
-    // Read the data into the buffer
-    for (size_t i = 0; i < bytesToRead && Wire.available(); ++i)
+  return true; // Return true if the read was successful
+}
+
+/**
+ * @brief Loads the chip's address counter for a sequential read.
+ *
+ * @param memoryAddress The address the next read starts at.
+ * @return true if the EEPROM acknowledged the address.
+ */
+bool EEPROM24LC32A::_setReadAddress(uint16_t memoryAddress)
+{
+  uint8_t header[2] = {(uint8_t)(memoryAddress >> 8), (uint8_t)(memoryAddress & 0xFF)};
+  return I2cBus::write(_deviceAddress, header, 2) == 0;
+}
+
+/**
+ * @brief Reads the next bytes from the chip's address counter.
+ *
+ * The 24LC32A keeps incrementing its address counter between requests (and
+ * wraps at the end of the array), so consecutive calls continue where the
+ * previous one stopped as long as nothing else addresses the chip.
+ *
+ * @param buffer Buffer for the data.
+ * @param length Number of bytes, at most the Wire buffer size.
+ * @return true if every byte was received.
+ */
+bool EEPROM24LC32A::_readNext(uint8_t *buffer, size_t length)
+{
+  return I2cBus::read(_deviceAddress, buffer, (uint8_t)length) == length;
+}
+
+/**
+ * @brief Checks whether the chip acknowledges its address.
+ *
+ * @return true if the chip answered.
+ */
+bool EEPROM24LC32A::isPresent()
+{
+  return I2cBus::probe(_deviceAddress);
+}
+
+/**
+ * @brief Streams a range of the EEPROM to a consumer.
+ *
+ * The memory address is sent once and the data is then pulled in chunks
+ * of the Wire buffer size, so the whole 4 KB array can be read with no
+ * buffer larger than one chunk. Data still waiting in the write-combining
+ * buffer is overlaid, and queued asynchronous writes are finished first.
+ * The page cache is bypassed.
+ *
+ * @param memoryAddress The starting address.
+ * @param length The number of bytes to read.
+ * @param consumer Called for every chunk; returning false stops the read.
+ * @param context Passed to the consumer.
+ * @return true if all bytes were read and consumed.
+ */
+bool EEPROM24LC32A::readStream(uint16_t memoryAddress, size_t length, EEPROMReadConsumer consumer, void *context)
+{
+  _drainAsync();
+
+  if (!_setReadAddress(memoryAddress))
+  {
+    return false;
+  }
+
+  uint8_t chunk[EEPROM24LC32A_WIRE_BUFFER];
+  while (length > 0)
+  {
+    size_t bytesToRead = length < sizeof(chunk) ? length : sizeof(chunk);
+    if (!_readNext(chunk, bytesToRead))
     {
-      buffer[i] = Wire.read();
+      return false;
     }
-
-    // Update the memory address, buffer pointer, and remaining length
-    memoryAddress += bytesToRead;
-    buffer += bytesToRead;
+    _overlayPending(memoryAddress, chunk, bytesToRead);
+    if (!consumer(chunk, bytesToRead, context))
+    {
+      return false;
+    }
+    memoryAddress = (memoryAddress + bytesToRead) & (DEVICE_SIZE - 1);
     length -= bytesToRead;
   }
+  return true;
+}
 
-  return true; // Return true if the read was successful
+/**
+ * @brief Sets the I2C clock.
+ *
+ * The 24LC32A supports 400 kHz fast mode at 2.5 V and above, which cuts
+ * the time of a full-array read to roughly a quarter of standard mode.
+ * The clock is shared by every device on the bus, see I2cBus::setClock().
+ *
+ * @param frequency Clock in Hz, e.g. 100000 or 400000.
+ */
+void EEPROM24LC32A::setClock(uint32_t frequency)
+{
+  I2cBus::setClock(frequency);
+}
+
+/**
+ * @brief Enables or disables write combining for writeByte().
+ *
+ * @param enabled true to buffer writeByte() calls.
+ */
+void EEPROM24LC32A::setWriteCombining(bool enabled)
+{
+  if (!enabled)
+  {
+    flush();
+  }
+  _writeCombining = enabled;
+}
+
+/**
+ * @brief Writes any bytes held by the write-combining buffer to the EEPROM.
+ *
+ * The pending bytes are written as one span from the first to the last
+ * pending byte. If there are holes in between, the span is first read back
+ * (with the pending bytes laid over it) so it still goes out as one page write.
+ * Queued asynchronous writes are finished first: they are older than the
+ * buffered bytes, and the chip would not acknowledge during their write cycle.
+ *
+ * @return true if the write was successful (or nothing was pending), false otherwise.
+ */
+bool EEPROM24LC32A::flush()
+{
+  if (_pendingMask == 0)
+  {
+    return true;
+  }
+  _drainAsync();
+
+  uint8_t first = 0;
+  while (!((_pendingMask >> first) & 1))
+  {
+    first++;
+  }
+  uint8_t last = PAGE_SIZE - 1;
+  while (!((_pendingMask >> last) & 1))
+  {
+    last--;
+  }
+  uint8_t length = last - first + 1;
+  uint32_t spanMask = (length == 32 ? 0xFFFFFFFFUL : (((uint32_t)1 << length) - 1)) << first;
+
+  bool ok;
+  if ((_pendingMask & spanMask) == spanMask)
+  {
+    ok = _writePage(_pendingPage + first, &_pendingData[first], length);
+  }
+  else
+  {
+    uint8_t span[PAGE_SIZE];
+    ok = readBytes(_pendingPage + first, span, length) && _writePage(_pendingPage + first, span, length);
+  }
+
+  if (ok)
+  {
+    _pendingMask = 0;
+  }
+  return ok;
+}
+
+/**
+ * @brief Writes bytes that all lie within one page.
+ *
+ * A whole page goes out in one transmission when the Wire buffer can hold
+ * it (ESP8266); with the 32-byte AVR buffer it takes two. With
+ * setSkipUnchangedWrites() the write is skipped if the bytes already match.
+ * The cache is updated after the chip acknowledged the write, and the page
+ * is dropped from it if the write failed.
+ *
+ * @param memoryAddress The starting address.
+ * @param data The data to write.
+ * @param length The number of bytes, must not cross a page boundary.
+ * @return true if the write was successful, false otherwise.
+ */
+bool EEPROM24LC32A::_writePage(uint16_t memoryAddress, const uint8_t *data, uint8_t length)
+{
+  if (_skipUnchanged)
+  {
+    uint8_t current[PAGE_SIZE];
+    bool read = _cache ? _readCached(memoryAddress, current, length) : _readRaw(memoryAddress, current, length);
+    if (read && memcmp(current, data, length) == 0)
+    {
+      _skippedWrites++;
+      return true;
+    }
+  }
+
+  // The cache only learns the new bytes once the chip has acknowledged them
+  uint16_t pageAddress = memoryAddress;
+  const uint8_t *pageData = data;
+  uint8_t pageLength = length;
+  while (length > 0)
+  {
+    uint8_t bytesToWrite = length;
+    if (bytesToWrite > EEPROM24LC32A_WIRE_BUFFER - 2)
+    {
+      bytesToWrite = EEPROM24LC32A_WIRE_BUFFER - 2;
+    }
+
+    uint8_t header[2] = {(uint8_t)(memoryAddress >> 8), (uint8_t)(memoryAddress & 0xFF)};
+    // Wait for the EEPROM to complete the write operation
+    if (I2cBus::write(_deviceAddress, header, 2, data, bytesToWrite) != 0 || !_waitForWrite())
+    {
+      // Unknown how much of the page the chip stored
+      _cacheInvalidate(pageAddress, pageLength);
+      return false;
+    }
+
+    memoryAddress += bytesToWrite;
+    data += bytesToWrite;
+    length -= bytesToWrite;
+  }
+  _cacheUpdate(pageAddress, pageData, pageLength);
+  return true;
+}
+
+/**
+ * @brief Copies pending write-combining bytes over data just read from the EEPROM.
+ *
+ * @param memoryAddress The address the data was read from.
+ * @param buffer The data read.
+ * @param length The number of bytes read.
+ */
+void EEPROM24LC32A::_overlayPending(uint16_t memoryAddress, uint8_t *buffer, size_t length)
+{
+  if (_pendingMask == 0 || memoryAddress >= _pendingPage + PAGE_SIZE || memoryAddress + length <= _pendingPage)
+  {
+    return;
+  }
+  for (uint8_t i = 0; i < PAGE_SIZE; i++)
+  {
+    uint16_t address = _pendingPage + i;
+    if (((_pendingMask >> i) & 1) && address >= memoryAddress && address < memoryAddress + length)
+    {
+      buffer[address - memoryAddress] = _pendingData[i];
+    }
+  }
 }
 
 /**
@@ -186,19 +429,392 @@ bool EEPROM24LC32A::readBytes(uint16_t memoryAddress, uint8_t *buffer, size_t le
  *
  * The 24LC32A EEPROM takes some time to complete a write operation.
  * This function ensures that the EEPROM is ready before another operation is performed.
- * It does this by polling the EEPROM until it acknowledges, indicating it is ready.
+ * It does this by polling the EEPROM until it acknowledges, indicating it is ready,
+ * and gives up after the write timeout so a missing chip cannot hang the system.
+ *
+ * @return true once the EEPROM acknowledges, false on timeout.
  */
-void EEPROM24LC32A::_waitForWrite()
+bool EEPROM24LC32A::_waitForWrite()
 {
-  // Continuously try to initiate communication with the EEPROM until it responds
+  unsigned long start = millis();
+  // Keep trying to initiate communication with the EEPROM until it responds
   while (true)
   {
-    Wire.beginTransmission(_deviceAddress);
     // If the EEPROM acknowledges, it is ready
-    if (Wire.endTransmission() == 0)
+    if (I2cBus::probe(_deviceAddress))
+    {
+      return true;
+    }
+    if (millis() - start > _writeTimeoutMs)
+    {
+      return false;
+    }
+  }
+}
+
+/**
+ * @brief Queues a write and returns at once.
+ *
+ * Bytes still in the write-combining buffer are flushed first (blocking),
+ * so an older writeByte() cannot overwrite the queued data later.
+ *
+ * @param memoryAddress The starting address in the EEPROM.
+ * @param data The data to write, owned by the caller.
+ * @param length The number of bytes to write.
+ * @param callback Optional completion callback.
+ * @param context Passed to the callback.
+ * @return true if queued, false if the queue is full or the flush failed.
+ */
+bool EEPROM24LC32A::writeBytesAsync(uint16_t memoryAddress, const uint8_t *data, size_t length,
+                                    EEPROMWriteCallback callback, void *context)
+{
+  if (_asyncCount >= EEPROM24LC32A_ASYNC_QUEUE)
+  {
+    return false;
+  }
+  // Bytes from earlier writeByte() calls must not land after (and over) this data
+  if (!flush())
+  {
+    return false;
+  }
+  AsyncWrite &job = _asyncQueue[(_asyncHead + _asyncCount) % EEPROM24LC32A_ASYNC_QUEUE];
+  job.address = memoryAddress;
+  job.data = data;
+  job.length = length;
+  job.written = 0;
+  job.callback = callback;
+  job.context = context;
+  _asyncCount++;
+  return true;
+}
+
+/**
+ * @brief Advances the queued writes by at most one I2C transaction.
+ *
+ * The page writes and acknowledge probes are queued on the I2cBus at
+ * I2cBus::PRIORITY_EEPROM, so display updates and other devices' traffic
+ * interleave with them and go first. Each call handles the result of the
+ * previous transaction, queues the next one if needed and then runs one
+ * I2cBus::poll(), which may also be another device's transaction.
+ *
+ * While a page write is in progress the EEPROM does not acknowledge its
+ * address, so a probe is queued until it does (or the write timeout
+ * expires). Once acknowledged, the page goes into the cache and the next
+ * page of the current job is sent; the job completes when its last page has
+ * been acknowledged.
+ */
+void EEPROM24LC32A::poll()
+{
+  _asyncStep();
+  I2cBus::poll();
+}
+
+/**
+ * @brief Handles the finished bus transaction and queues the next one.
+ */
+void EEPROM24LC32A::_asyncStep()
+{
+  if (_asyncInFlight)
+  {
+    if (!_asyncTransaction.done)
+    {
+      return;
+    }
+    _asyncInFlight = false;
+    AsyncWrite &job = _asyncQueue[_asyncHead];
+
+    if (!_asyncWaiting)
+    {
+      // The page itself went out
+      if (_asyncTransaction.status != 0)
+      {
+        _finishAsync(false);
+        return;
+      }
+      _asyncWaiting = true;
+      _asyncStarted = millis();
+    }
+    else if (_asyncTransaction.status == 0)
+    {
+      _asyncWaiting = false;
+      _cacheUpdate(job.address + job.written - _asyncSent, job.data + job.written - _asyncSent, _asyncSent);
+      if (job.written >= job.length)
+      {
+        _finishAsync(true);
+        return;
+      }
+    }
+    else if (millis() - _asyncStarted > _writeTimeoutMs)
+    {
+      _asyncWaiting = false;
+      _finishAsync(false);
+      return;
+    }
+  }
+
+  if (_asyncWaiting)
+  {
+    // Address-only probe: acknowledged once the write cycle is over
+    _submitAsync(nullptr, 0, nullptr, 0);
+    return;
+  }
+
+  if (_asyncCount == 0)
+  {
+    return;
+  }
+
+  AsyncWrite &job = _asyncQueue[_asyncHead];
+  if (job.written >= job.length)
+  {
+    _finishAsync(true); // Zero-length write
+    return;
+  }
+
+  // Same chunking as writeBytes(): stay inside the page and the Wire buffer
+  uint16_t address = job.address + job.written;
+  size_t bytesToWrite = PAGE_SIZE - (address & (PAGE_SIZE - 1));
+  if (bytesToWrite > job.length - job.written)
+  {
+    bytesToWrite = job.length - job.written;
+  }
+  if (bytesToWrite > EEPROM24LC32A_WIRE_BUFFER - 2)
+  {
+    bytesToWrite = EEPROM24LC32A_WIRE_BUFFER - 2;
+  }
+
+  _asyncHeader[0] = (uint8_t)(address >> 8);
+  _asyncHeader[1] = (uint8_t)(address & 0xFF);
+  // Counted as written right away, so a failure invalidates this page too
+  job.written += bytesToWrite;
+  _asyncSent = bytesToWrite;
+  _submitAsync(_asyncHeader, 2, job.data + job.written - bytesToWrite, bytesToWrite);
+}
+
+/**
+ * @brief Queues the page write or probe transaction on the bus.
+ */
+void EEPROM24LC32A::_submitAsync(const uint8_t *header, uint8_t headerLength, const uint8_t *data, uint8_t length)
+{
+  _asyncTransaction.address = _deviceAddress;
+  _asyncTransaction.header = header;
+  _asyncTransaction.headerLength = headerLength;
+  _asyncTransaction.writeData = data;
+  _asyncTransaction.writeLength = length;
+  _asyncTransaction.readBuffer = nullptr;
+  _asyncTransaction.readLength = 0;
+  _asyncTransaction.priority = I2cBus::PRIORITY_EEPROM;
+  _asyncTransaction.batchable = false; // Every page write starts with its own address
+  _asyncTransaction.callback = nullptr;
+  _asyncTransaction.context = nullptr;
+  _asyncInFlight = I2cBus::submit(&_asyncTransaction);
+  if (!_asyncInFlight)
+  {
+    _asyncWaiting = false;
+    _finishAsync(false);
+  }
+}
+
+/**
+ * @brief Completes the current async write and moves on to the next one.
+ *
+ * On failure every page the job has sent so far is dropped from the cache,
+ * since it is unknown what the chip stored.
+ *
+ * @param success Passed to the callback.
+ */
+void EEPROM24LC32A::_finishAsync(bool success)
+{
+  AsyncWrite job = _asyncQueue[_asyncHead];
+  if (!success)
+  {
+    _cacheInvalidate(job.address, job.written);
+  }
+  _asyncHead = (_asyncHead + 1) % EEPROM24LC32A_ASYNC_QUEUE;
+  _asyncCount--;
+  if (job.callback)
+  {
+    job.callback(success, job.context);
+  }
+}
+
+/**
+ * @brief Runs queued writes to completion, blocking.
+ */
+void EEPROM24LC32A::_drainAsync()
+{
+  while (isBusy())
+  {
+    poll();
+  }
+}
+/**
+ * @brief Enables a read-through page cache in RAM.
+ *
+ * @param pages Number of pages to cache, 0 to disable.
+ * @return true if the cache could be allocated.
+ */
+bool EEPROM24LC32A::enableCache(uint8_t pages)
+{
+  delete[] _cache;
+  _cache = nullptr;
+  _cachePages = 0;
+  if (pages == 0)
+  {
+    return true;
+  }
+  _cache = new CachePage[pages];
+  if (!_cache)
+  {
+    return false;
+  }
+  _cachePages = pages;
+  invalidateCache();
+  return true;
+}
+
+/**
+ * @brief Drops every cached page.
+ */
+void EEPROM24LC32A::invalidateCache()
+{
+  for (uint8_t i = 0; i < _cachePages; i++)
+  {
+    _cache[i].valid = false;
+    _cache[i].lastUse = 0;
+  }
+  _cacheClock = 0;
+}
+
+/**
+ * @brief Resets the cache and skipped-write counters.
+ */
+void EEPROM24LC32A::resetStats()
+{
+  _cacheHits = 0;
+  _cacheMisses = 0;
+  _skippedWrites = 0;
+}
+
+/**
+ * @brief Reads through the page cache, one page segment at a time.
+ *
+ * @param memoryAddress The starting address.
+ * @param buffer Buffer for the data.
+ * @param length The number of bytes to read.
+ * @return true if the read was successful, false otherwise.
+ */
+bool EEPROM24LC32A::_readCached(uint16_t memoryAddress, uint8_t *buffer, size_t length)
+{
+  while (length > 0)
+  {
+    uint8_t offset = memoryAddress & (PAGE_SIZE - 1);
+    size_t chunk = PAGE_SIZE - offset;
+    if (chunk > length)
+    {
+      chunk = length;
+    }
+    CachePage *slot = _cacheLookup(memoryAddress - offset);
+    if (!slot)
+    {
+      return false;
+    }
+    memcpy(buffer, &slot->data[offset], chunk);
+    memoryAddress += chunk;
+    buffer += chunk;
+    length -= chunk;
+  }
+  return true;
+}
+
+/**
+ * @brief Finds the cache slot holding a page, loading it on a miss.
+ *
+ * The least recently used slot is replaced. The cache is write-through, so
+ * nothing needs writing back on eviction.
+ *
+ * @param page Address of the first byte of the page.
+ * @return The slot, or nullptr if the page could not be read.
+ */
+EEPROM24LC32A::CachePage *EEPROM24LC32A::_cacheLookup(uint16_t page)
+{
+  if (++_cacheClock == 0)
+  {
+    // Stamp wrapped, restart the LRU order
+    for (uint8_t i = 0; i < _cachePages; i++)
+    {
+      _cache[i].lastUse = 0;
+    }
+    _cacheClock = 1;
+  }
+
+  uint8_t victim = 0;
+  for (uint8_t i = 0; i < _cachePages; i++)
+  {
+    if (_cache[i].valid && _cache[i].page == page)
+    {
+      _cacheHits++;
+      _cache[i].lastUse = _cacheClock;
+      return &_cache[i];
+    }
+    if (_cache[victim].valid && (!_cache[i].valid || _cache[i].lastUse < _cache[victim].lastUse))
+    {
+      victim = i;
+    }
+  }
+
+  _cacheMisses++;
+  CachePage &slot = _cache[victim];
+  slot.valid = false;
+  if (!_readRaw(page, slot.data, PAGE_SIZE))
+  {
+    return nullptr;
+  }
+  slot.page = page;
+  slot.valid = true;
+  slot.lastUse = _cacheClock;
+  return &slot;
+}
+
+/**
+ * @brief Copies freshly written bytes into the cache if their page is cached.
+ *
+ * @param memoryAddress The address written.
+ * @param data The data written.
+ * @param length The number of bytes, within one page.
+ */
+void EEPROM24LC32A::_cacheUpdate(uint16_t memoryAddress, const uint8_t *data, uint8_t length)
+{
+  uint16_t page = memoryAddress & ~(uint16_t)(PAGE_SIZE - 1);
+  for (uint8_t i = 0; i < _cachePages; i++)
+  {
+    if (_cache[i].valid && _cache[i].page == page)
+    {
+      memcpy(&_cache[i].data[memoryAddress - page], data, length);
+      return;
+    }
+  }
+}
+
+/**
+ * @brief Drops every cached page overlapping a range.
+ *
+ * @param memoryAddress The start of the range.
+ * @param length The number of bytes.
+ */
+void EEPROM24LC32A::_cacheInvalidate(uint16_t memoryAddress, size_t length)
+{
+  if (length == 0)
+  {
+    return;
+  }
+  uint16_t first = memoryAddress & ~(uint16_t)(PAGE_SIZE - 1);
+  uint16_t last = (memoryAddress + length - 1) & ~(uint16_t)(PAGE_SIZE - 1);
+  for (uint8_t i = 0; i < _cachePages; i++)
+  {
+    if (_cache[i].valid && _cache[i].page >= first && _cache[i].page <= last)
     {
-      break; // Exit the loop when the EEPROM is ready
+      _cache[i].valid = false;
     }
   }
 }
-#endif // The header
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "EepromBank.h"
+#include "logger.h"
+
+/**
+ * Constructor for a bank of 24LC32A chips.
+ *
+ * @param chips Array of chipCount chips, chip 0 first. Usually at 0x50, 0x51...
+ * @param chipCount Number of chips (1-8).
+ */
+EepromBank::EepromBank(EEPROM24LC32A *const *chips, uint8_t chipCount)
+    : _chipCount(chipCount), _writeFailed(false)
+{
+  if (_chipCount > MAX_CHIPS)
+  {
+    Logger::warning("EepromBank: only " + String(MAX_CHIPS) + " chips supported");
+    _chipCount = MAX_CHIPS;
+  }
+  for (uint8_t i = 0; i < _chipCount; i++)
+  {
+    _chips[i] = chips[i];
+  }
+}
+
+/**
+ * Checks that every chip acknowledges its address.
+ *
+ * @return false if a chip is missing.
+ */
+bool EepromBank::begin()
+{
+  bool ok = true;
+  for (uint8_t i = 0; i < _chipCount; i++)
+  {
+    if (!_chips[i]->isPresent())
+    {
+      Logger::error("EepromBank: chip " + String(i) + " not responding");
+      ok = false;
+    }
+  }
+  Logger::info("EepromBank initialized with " + String(_chipCount) + " chips");
+  return ok;
+}
+
+/**
+ * Writes a byte at a linear address.
+ *
+ * @param address The linear address.
+ * @param data The byte to write.
+ * @return true if the write was successful.
+ */
+bool EepromBank::writeByte(uint16_t address, uint8_t data)
+{
+  if (!inRange(address, 1))
+  {
+    return false;
+  }
+  return _chips[chipOf(address)]->writeByte(chipAddressOf(address), data);
+}
+
+/**
+ * Reads a byte from a linear address.
+ *
+ * @param address The linear address.
+ * @return The byte read, 0 if the address is out of range.
+ */
+uint8_t EepromBank::readByte(uint16_t address)
+{
+  if (!inRange(address, 1))
+  {
+    return 0;
+  }
+  return _chips[chipOf(address)]->readByte(chipAddressOf(address));
+}
+
+/**
+ * Writes a block, one page piece at a time, round robin over the chips.
+ *
+ * Every piece is queued on its chip with writeBytesAsync(), and the queues
+ * are polled while waiting for room, so the chips' write cycles overlap.
+ * Returns once every piece has been acknowledged.
+ *
+ * @param address The linear start address.
+ * @param data The data to write.
+ * @param length Number of bytes to write.
+ * @return true if every page write succeeded.
+ */
+bool EepromBank::writeBytes(uint16_t address, const uint8_t *data, size_t length)
+{
+  if (!inRange(address, length))
+  {
+    return false;
+  }
+
+  // Bytes still sitting in a write-combining buffer must not land after ours
+  for (uint8_t i = 0; i < _chipCount; i++)
+  {
+    _chips[i]->flush();
+  }
+
+  _writeFailed = false;
+  while (length > 0)
+  {
+    size_t piece = EEPROM24LC32A::PAGE_SIZE - (address % EEPROM24LC32A::PAGE_SIZE);
+    if (piece > length)
+    {
+      piece = length;
+    }
+    EEPROM24LC32A *chip = _chips[chipOf(address)];
+    while (!chip->writeBytesAsync(chipAddressOf(address), data, piece, writeDone, this))
+    {
+      pollAll();
+    }
+    address += piece;
+    data += piece;
+    length -= piece;
+  }
+
+  bool busy = true;
+  while (busy)
+  {
+    pollAll();
+    busy = false;
+    for (uint8_t i = 0; i < _chipCount; i++)
+    {
+      busy |= _chips[i]->isBusy();
+    }
+  }
+  return !_writeFailed;
+}
+
+/**
+ * Reads a block with one sequential read per chip.
+ *
+ * A chip's pages within the block are consecutive on the chip, so each
+ * chip's share is a single readStream() whose chunks are scattered back to
+ * their linear positions.
+ *
+ * @param address The linear start address.
+ * @param buffer Buffer to store the data.
+ * @param length Number of bytes to read.
+ * @return true if the read was successful.
+ */
+bool EepromBank::readBytes(uint16_t address, uint8_t *buffer, size_t length)
+{
+  if (!inRange(address, length))
+  {
+    return false;
+  }
+  if (length == 0)
+  {
+    return true;
+  }
+
+  uint16_t last = address + length - 1;
+  uint16_t firstPage = address / EEPROM24LC32A::PAGE_SIZE;
+  uint16_t lastPage = last / EEPROM24LC32A::PAGE_SIZE;
+  for (uint8_t chip = 0; chip < _chipCount; chip++)
+  {
+    // First and last linear page of the block on this chip
+    uint16_t from = firstPage + (chip + _chipCount - firstPage % _chipCount) % _chipCount;
+    if (from > lastPage)
+    {
+      continue;
+    }
+    uint16_t to = lastPage - (lastPage % _chipCount + _chipCount - chip) % _chipCount;
+
+    uint16_t begin = from == firstPage ? address : from * EEPROM24LC32A::PAGE_SIZE;
+    uint16_t end = to == lastPage ? last : to * EEPROM24LC32A::PAGE_SIZE + EEPROM24LC32A::PAGE_SIZE - 1;
+
+    ReadState state;
+    state.bank = this;
+    state.buffer = buffer;
+    state.start = address;
+    state.chip = chip;
+    state.chipAddress = chipAddressOf(begin);
+    if (!_chips[chip]->readStream(state.chipAddress, chipAddressOf(end) - state.chipAddress + 1, scatter, &state))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Copies a chunk of one chip's share to its place in the read buffer,
+ * one page piece at a time.
+ */
+bool EepromBank::scatter(const uint8_t *data, size_t length, void *context)
+{
+  ReadState *state = (ReadState *)context;
+  while (length > 0)
+  {
+    size_t piece = EEPROM24LC32A::PAGE_SIZE - (state->chipAddress % EEPROM24LC32A::PAGE_SIZE);
+    if (piece > length)
+    {
+      piece = length;
+    }
+    uint16_t linear = state->bank->linearAddressOf(state->chip, state->chipAddress);
+    memcpy(state->buffer + (linear - state->start), data, piece);
+    state->chipAddress += piece;
+    data += piece;
+    length -= piece;
+  }
+  return true;
+}
+
+void EepromBank::writeDone(bool success, void *context)
+{
+  if (!success)
+  {
+    ((EepromBank *)context)->_writeFailed = true;
+  }
+}
+
+uint16_t EepromBank::chipAddressOf(uint16_t address) const
+{
+  uint16_t page = address / EEPROM24LC32A::PAGE_SIZE;
+  return (page / _chipCount) * EEPROM24LC32A::PAGE_SIZE + address % EEPROM24LC32A::PAGE_SIZE;
+}
+
+uint16_t EepromBank::linearAddressOf(uint8_t chip, uint16_t chipAddress) const
+{
+  uint16_t page = chipAddress / EEPROM24LC32A::PAGE_SIZE;
+  return (page * _chipCount + chip) * EEPROM24LC32A::PAGE_SIZE + chipAddress % EEPROM24LC32A::PAGE_SIZE;
+}
+
+/**
+ * Checks that a transfer stays inside the address space.
+ *
+ * @param address The linear start address.
+ * @param length Transfer length.
+ * @return false (and logs an error) if it does not.
+ */
+bool EepromBank::inRange(uint16_t address, size_t length) const
+{
+  if ((uint32_t)address + length > size())
+  {
+    Logger::error("EepromBank: transfer outside address space: " + String(address));
+    return false;
+  }
+  return true;
+}
+
+void EepromBank::pollAll()
+{
+  for (uint8_t i = 0; i < _chipCount; i++)
+  {
+    _chips[i]->poll();
+  }
+}
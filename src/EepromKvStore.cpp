@@ -0,0 +1,433 @@
+#include "EepromKvStore.h"
+#include "Crc.h"
+#include "logger.h"
+
+/**
+ * Constructor for the key-value store.
+ *
+ * @param eeprom The EEPROM holding the log.
+ * @param startAddress First byte of the region, page aligned.
+ * @param size Region size in bytes, a multiple of the page size.
+ */
+EepromKvStore::EepromKvStore(EEPROM24LC32A *eeprom, uint16_t startAddress, uint16_t size)
+    : _eeprom(eeprom), _start(startAddress), _pageCount(size / EEPROM24LC32A::PAGE_SIZE),
+      _entryCount(0), _openPage(0), _fill(0), _dirty(false), _sequence(0), _haveNewest(false),
+      _indexOverflow(false), _pageWrites(0), _relocations(0)
+{
+}
+
+/**
+ * Scans the whole region once and builds the index.
+ *
+ * For every key the record with the newest sequence number wins. The page
+ * holding the newest record overall is where appending continues.
+ *
+ * If the region holds more keys than EEPROM_KV_MAX_KEYS, the extra ones
+ * cannot be indexed, and garbage collection would drop them. The store then
+ * refuses put() and remove() (get() still works) until it is formatted or
+ * rebuilt with a larger EEPROM_KV_MAX_KEYS.
+ *
+ * @return false if the region could not be read or holds too many keys.
+ */
+bool EepromKvStore::begin()
+{
+  _entryCount = 0;
+  _haveNewest = false;
+  _sequence = 0;
+  _indexOverflow = false;
+
+  ScanState state;
+  state.store = this;
+  state.pageIndex = 0;
+  state.fill = 0;
+  if (!_eeprom->readStream(_start, (size_t)_pageCount * EEPROM24LC32A::PAGE_SIZE, scanChunk, &state))
+  {
+    Logger::error("KV store: scan failed");
+    return false;
+  }
+
+  if (_haveNewest)
+  {
+    _sequence++;
+  }
+  else
+  {
+    // Empty store, the first record goes to page 0
+    _openPage = _pageCount - 1;
+    _fill = EEPROM24LC32A::PAGE_SIZE;
+  }
+  _dirty = false;
+  Logger::info("KV store: " + String(count()) + " keys, appending at page " + String(_openPage));
+  if (_indexOverflow)
+  {
+    Logger::error("KV store: more than " + String(EEPROM_KV_MAX_KEYS) + " keys stored, writes disabled");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Fills the region with 0xFF and forgets every key.
+ *
+ * @return false on a write error.
+ */
+bool EepromKvStore::format()
+{
+  memset(_page, 0xFF, sizeof(_page));
+  for (uint16_t i = 0; i < _pageCount; i++)
+  {
+    if (!_eeprom->writeBytes(pageAddress(i), _page, EEPROM24LC32A::PAGE_SIZE))
+    {
+      return false;
+    }
+    _pageWrites++;
+  }
+  _entryCount = 0;
+  _openPage = _pageCount - 1;
+  _fill = EEPROM24LC32A::PAGE_SIZE;
+  _dirty = false;
+  _indexOverflow = false;
+  return true;
+}
+
+/**
+ * Stores a value. Unchanged values are not written again.
+ *
+ * @param key Any key but NO_KEY.
+ * @param value The value.
+ * @param length Value length, at most EEPROM_KV_MAX_VALUE.
+ * @return false if the key or length is invalid, the index is full or the write failed.
+ */
+bool EepromKvStore::put(uint8_t key, const void *value, uint8_t length)
+{
+  if (key == NO_KEY || length > EEPROM_KV_MAX_VALUE || _indexOverflow)
+  {
+    return false;
+  }
+
+  int8_t index = find(key);
+  if (index >= 0 && _entries[index].length == length && memcmp(_entries[index].value, value, length) == 0)
+  {
+    return true;
+  }
+  if (index < 0 && _entryCount >= EEPROM_KV_MAX_KEYS)
+  {
+    Logger::warning("KV store: index full");
+    return false;
+  }
+
+  uint16_t address = append(key, length, (const uint8_t *)value);
+  if (address == 0xFFFF)
+  {
+    return false;
+  }
+
+  // Garbage collection may have dropped a tombstone of this key
+  index = find(key);
+  if (index < 0)
+  {
+    index = _entryCount++;
+    _entries[index].key = key;
+  }
+  _entries[index].length = length;
+  _entries[index].sequence = _sequence - 1;
+  _entries[index].address = address;
+  memcpy(_entries[index].value, value, length);
+  return true;
+}
+
+/**
+ * Copies a value from the index, without touching the EEPROM.
+ *
+ * @param key The key.
+ * @param buffer Destination.
+ * @param length Destination size; longer values are truncated.
+ * @return false if the key is not set.
+ */
+bool EepromKvStore::get(uint8_t key, void *buffer, uint8_t length) const
+{
+  int8_t index = findLive(key);
+  if (index < 0)
+  {
+    return false;
+  }
+  memcpy(buffer, _entries[index].value, length < _entries[index].length ? length : _entries[index].length);
+  return true;
+}
+
+uint8_t EepromKvStore::valueLength(uint8_t key) const
+{
+  int8_t index = findLive(key);
+  return index < 0 ? 0 : _entries[index].length;
+}
+
+/**
+ * Removes a key by appending a tombstone.
+ *
+ * The tombstone stays in the index until garbage collection reaches its
+ * page; by then every older record of the key has been overwritten.
+ *
+ * @param key The key.
+ * @return false if the key was not set or the write failed.
+ */
+bool EepromKvStore::remove(uint8_t key)
+{
+  if (_indexOverflow || findLive(key) < 0)
+  {
+    return false;
+  }
+  uint16_t address = append(key, DELETED, nullptr);
+  if (address == 0xFFFF)
+  {
+    return false;
+  }
+  int8_t index = find(key);
+  _entries[index].length = DELETED;
+  _entries[index].sequence = _sequence - 1;
+  _entries[index].address = address;
+  return true;
+}
+
+uint8_t EepromKvStore::count() const
+{
+  uint8_t live = 0;
+  for (uint8_t i = 0; i < _entryCount; i++)
+  {
+    if (_entries[i].length != DELETED)
+    {
+      live++;
+    }
+  }
+  return live;
+}
+
+/**
+ * Collects the streamed region into pages and parses each complete one.
+ */
+bool EepromKvStore::scanChunk(const uint8_t *data, size_t length, void *context)
+{
+  ScanState *state = (ScanState *)context;
+  while (length > 0)
+  {
+    uint8_t bytes = EEPROM24LC32A::PAGE_SIZE - state->fill;
+    if (bytes > length)
+    {
+      bytes = length;
+    }
+    memcpy(state->page + state->fill, data, bytes);
+    state->fill += bytes;
+    data += bytes;
+    length -= bytes;
+    if (state->fill == EEPROM24LC32A::PAGE_SIZE)
+    {
+      state->store->scanPage(state->pageIndex++, state->page);
+      state->fill = 0;
+    }
+  }
+  return true;
+}
+
+/**
+ * Parses the records of one page, stopping at the first erased or corrupt one.
+ *
+ * @param pageIndex Page within the region.
+ * @param page The page contents.
+ */
+void EepromKvStore::scanPage(uint16_t pageIndex, const uint8_t *page)
+{
+  uint8_t offset = 0;
+  bool newest = false;
+  while (offset + RECORD_OVERHEAD <= EEPROM24LC32A::PAGE_SIZE)
+  {
+    const uint8_t *record = page + offset;
+    uint8_t key = record[0];
+    uint8_t length = record[1] & LENGTH_MASK;
+    if (key == NO_KEY || length > EEPROM_KV_MAX_VALUE || offset + RECORD_OVERHEAD + length > EEPROM24LC32A::PAGE_SIZE)
+    {
+      break;
+    }
+    if (Crc::crc8(record, 4 + length) != record[4 + length])
+    {
+      break;
+    }
+    uint16_t sequence = record[2] | ((uint16_t)record[3] << 8);
+
+    int8_t index = find(key);
+    if (index < 0)
+    {
+      if (_entryCount < EEPROM_KV_MAX_KEYS)
+      {
+        index = _entryCount++;
+        _entries[index].key = key;
+        _entries[index].sequence = sequence - 1;
+      }
+      else
+      {
+        _indexOverflow = true;
+      }
+    }
+    if (index >= 0 && newer(sequence, _entries[index].sequence))
+    {
+      _entries[index].length = (record[1] & DELETED) ? DELETED : length;
+      _entries[index].sequence = sequence;
+      _entries[index].address = pageAddress(pageIndex) + offset;
+      memcpy(_entries[index].value, record + 4, length);
+    }
+
+    if (!_haveNewest || newer(sequence, _sequence))
+    {
+      _haveNewest = true;
+      _sequence = sequence;
+      newest = true;
+    }
+    offset += RECORD_OVERHEAD + length;
+  }
+
+  if (newest)
+  {
+    _openPage = pageIndex;
+    _fill = offset;
+    memcpy(_page, page, offset);
+    memset(_page + offset, 0xFF, EEPROM24LC32A::PAGE_SIZE - offset);
+  }
+}
+
+/**
+ * Appends a record, reclaiming the oldest pages until it fits.
+ *
+ * Only the bytes from the record to the end of the page are written,
+ * unless garbage collection rewrote the start of the page too.
+ *
+ * @return The record address, 0xFFFF if the store is full or the write failed.
+ */
+uint16_t EepromKvStore::append(uint8_t key, uint8_t length, const uint8_t *value)
+{
+  uint8_t size = RECORD_OVERHEAD + (length & LENGTH_MASK);
+  for (uint16_t tries = 0; _fill + size > EEPROM24LC32A::PAGE_SIZE; tries++)
+  {
+    if (tries >= _pageCount)
+    {
+      Logger::error("KV store: full");
+      return 0xFFFF;
+    }
+    if (_dirty)
+    {
+      // The compacted records of the page we are leaving must reach the chip
+      if (!_eeprom->writeBytes(pageAddress(_openPage), _page, EEPROM24LC32A::PAGE_SIZE))
+      {
+        return 0xFFFF;
+      }
+      _pageWrites++;
+      _dirty = false;
+    }
+    reclaimNextPage();
+  }
+
+  uint8_t offset = _fill;
+  encode(key, length, _sequence, value);
+  uint8_t from = _dirty ? 0 : offset;
+  if (!_eeprom->writeBytes(pageAddress(_openPage) + from, _page + from, EEPROM24LC32A::PAGE_SIZE - from))
+  {
+    _fill = offset;
+    memset(_page + offset, 0xFF, EEPROM24LC32A::PAGE_SIZE - offset);
+    return 0xFFFF;
+  }
+  _pageWrites++;
+  _dirty = false;
+  _sequence++;
+  return pageAddress(_openPage) + offset;
+}
+
+/**
+ * Opens the next page for appending and compacts the oldest page into it.
+ *
+ * The page after the open page never holds live records: its records were
+ * copied forward when it was the oldest page. So the next page can be
+ * overwritten, and the live records of the page after it (the oldest one)
+ * are copied into its new image with new sequence numbers. The oldest page
+ * keeps its copies until the log comes round to it again, by which time the
+ * new image has been written, so a reset during the rewrite loses nothing.
+ * Tombstones of the oldest page are dropped: nothing older is left for them
+ * to hide.
+ */
+void EepromKvStore::reclaimNextPage()
+{
+  _openPage = (_openPage + 1) % _pageCount;
+  _fill = 0;
+  memset(_page, 0xFF, sizeof(_page));
+  // Always rewrite the whole page, so none of its old records survive
+  _dirty = true;
+
+  // Only a store written before compaction moved forward has live records
+  // here; they can only be carried over in place.
+  carryOver(_openPage);
+  carryOver((_openPage + 1) % _pageCount);
+}
+
+/**
+ * Re-encodes the live records of a page into the open page image and drops
+ * its tombstones from the index. Records that do not fit stay where they are.
+ *
+ * @param pageIndex The page to move records out of.
+ */
+void EepromKvStore::carryOver(uint16_t pageIndex)
+{
+  for (uint8_t i = 0; i < _entryCount; i++)
+  {
+    Entry &entry = _entries[i];
+    if (pageOf(entry.address) != pageIndex)
+    {
+      continue;
+    }
+    if (entry.length == DELETED)
+    {
+      _entries[i--] = _entries[--_entryCount];
+      continue;
+    }
+    if (_fill + RECORD_OVERHEAD + entry.length > EEPROM24LC32A::PAGE_SIZE)
+    {
+      continue;
+    }
+    entry.address = pageAddress(_openPage) + _fill;
+    entry.sequence = _sequence;
+    encode(entry.key, entry.length, _sequence++, entry.value);
+    _relocations++;
+  }
+}
+
+/**
+ * Encodes a record into the open page image and advances _fill.
+ */
+void EepromKvStore::encode(uint8_t key, uint8_t length, uint16_t sequence, const uint8_t *value)
+{
+  uint8_t *record = _page + _fill;
+  uint8_t valueLength = length & LENGTH_MASK;
+  record[0] = key;
+  record[1] = length;
+  record[2] = sequence & 0xFF;
+  record[3] = sequence >> 8;
+  if (valueLength > 0)
+  {
+    memcpy(record + 4, value, valueLength);
+  }
+  record[4 + valueLength] = Crc::crc8(record, 4 + valueLength);
+  _fill += RECORD_OVERHEAD + valueLength;
+}
+
+int8_t EepromKvStore::find(uint8_t key) const
+{
+  for (uint8_t i = 0; i < _entryCount; i++)
+  {
+    if (_entries[i].key == key)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int8_t EepromKvStore::findLive(uint8_t key) const
+{
+  int8_t index = find(key);
+  return (index >= 0 && _entries[index].length != DELETED) ? index : -1;
+}
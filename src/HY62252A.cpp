@@ -11,7 +11,8 @@
  * @param we_pin Write Enable control pin.
  */
 HY62252A::HY62252A(uint8_t *addr_pins, uint8_t *data_pins, uint8_t ce_pin, uint8_t oe_pin, uint8_t we_pin)
-    : _addr_pins(addr_pins), _data_pins(data_pins), _ce_pin(ce_pin), _oe_pin(oe_pin), _we_pin(we_pin)
+    : _addr_pins(addr_pins), _data_pins(data_pins), _ce_pin(ce_pin), _oe_pin(oe_pin), _we_pin(we_pin),
+      _dataBusMode(0xFF), _lastAddress(0), _addressValid(false), _chainedRegisters(false)
 {
   _shiftRegister1 = nullptr;
   _shiftRegister2 = nullptr;
@@ -32,7 +33,8 @@ HY62252A::HY62252A(uint8_t *addr_pins, uint8_t *data_pins, uint8_t ce_pin, uint8
 HY62252A::HY62252A(ShiftRegister74HC595 *shiftRegister1, ShiftRegister74HC595 *shiftRegister2, uint8_t *data_pins,
                    uint8_t ce_pin, uint8_t oe_pin, uint8_t we_pin, uint8_t addr_bits_in_shift_register1, uint8_t addr_bits_in_shift_register2)
     : _shiftRegister1(shiftRegister1), _shiftRegister2(shiftRegister2), _data_pins(data_pins),
-      _ce_pin(ce_pin), _oe_pin(oe_pin), _we_pin(we_pin), _addr_bits_in_shift_register1(addr_bits_in_shift_register1), _addr_bits_in_shift_register2(addr_bits_in_shift_register2)
+      _ce_pin(ce_pin), _oe_pin(oe_pin), _we_pin(we_pin), _addr_bits_in_shift_register1(addr_bits_in_shift_register1), _addr_bits_in_shift_register2(addr_bits_in_shift_register2),
+      _dataBusMode(0xFF), _lastAddress(0), _addressValid(false), _chainedRegisters(false)
 {
   _addr_pins = nullptr; // Address pins handled by shift registers
 }
@@ -47,6 +49,7 @@ void HY62252A::begin()
   if (_shiftRegister1 && _shiftRegister2)
   {
     Logger::log(TRACE, "Initializing with shift registers...");
+    _chainedRegisters = _shiftRegister1->sharesPinsWith(_shiftRegister2);
     _shiftRegister1->clearAll();
     _shiftRegister2->clearAll();
     _shiftRegister1->updateRegisters();
@@ -66,6 +69,8 @@ void HY62252A::begin()
     Logger::log(ERROR, "No shift registers or GPIO pins found for address!");
     return;
   }
+  _addressValid = false;
+  _dataBusMode = 0xFF;
 
   // Set data bus to input initially for reading
   setDataBusMode(INPUT);
@@ -89,34 +94,70 @@ void HY62252A::begin()
 void HY62252A::setAddress(uint16_t address)
 {
   Logger::log(TRACE, "setAddress(): " + String(address));
+  latchAddress(address);
 
-  // Use shift registers for address lines
-  if (_shiftRegister1)
+  // Optional delay to ensure everything has time to settle
+  delayMicroseconds(5);
+}
+
+/**
+ * Puts an address on the bus without logging or settle delay.
+ * Only the GPIO lines or shift registers whose bits differ from the previously
+ * latched address are touched, so sequential bursts on separately wired
+ * registers mostly shift out one byte. Daisy-chained registers (same pins)
+ * always get both bytes, since every shift passes through the whole chain.
+ *
+ * @param address The 16-bit address to set on the address bus.
+ */
+void HY62252A::latchAddress(uint16_t address)
+{
+  uint16_t changed = _addressValid ? (uint16_t)(address ^ _lastAddress) : 0xFFFF;
+  if (changed == 0)
   {
-    Logger::log(TRACE, "Setting address using shift register 1");
-    for (uint8_t i = 0; i < _addr_bits_in_shift_register1; i++)
+    return;
+  }
+
+  if (_shiftRegister1 && _shiftRegister2)
+  {
+    uint8_t mask1 = (uint8_t)((1 << _addr_bits_in_shift_register1) - 1);
+    uint8_t mask2 = (uint8_t)((1 << _addr_bits_in_shift_register2) - 1);
+    bool changed1 = changed & mask1;
+    bool changed2 = (changed >> _addr_bits_in_shift_register1) & mask2;
+    _shiftRegister1->setBits(0, mask1, (uint8_t)address);
+    _shiftRegister2->setBits(0, mask2, (uint8_t)(address >> _addr_bits_in_shift_register1));
+    if (_chainedRegisters)
     {
-      bool bitValue = (address >> i) & 1;
-      Logger::trace("Shift Register 1 Pin " + String(i) + ": " + String(bitValue));
-      _shiftRegister1->setPin(i, bitValue);
+      // One daisy chain: every update shifts through both chips, so both
+      // bytes have to go out (register 1 first, it ends up in the far chip).
+      _shiftRegister1->updateRegisters();
+      _shiftRegister2->updateRegisters();
+    }
+    else
+    {
+      if (changed1)
+      {
+        _shiftRegister1->updateRegisters();
+      }
+      if (changed2)
+      {
+        _shiftRegister2->updateRegisters();
+      }
     }
-    _shiftRegister1->updateRegisters();
   }
 
-  if (_shiftRegister2)
+  if (_addr_pins)
   {
-    Logger::log(TRACE, "Setting address using shift register 2");
-    for (uint8_t i = 0; i < _addr_bits_in_shift_register2; i++)
+    for (uint8_t i = 0; i < 15; i++)
     {
-      bool bitValue = (address >> (_addr_bits_in_shift_register1 + i)) & 1;
-      Logger::trace("Shift Register 2 Pin " + String(i) + ": " + String(bitValue));
-      _shiftRegister2->setPin(i, bitValue);
+      if ((changed >> i) & 1)
+      {
+        digitalWrite(_addr_pins[i], (address >> i) & 1);
+      }
     }
-    _shiftRegister2->updateRegisters();
   }
 
-  // Optional delay to ensure everything has time to settle
-  delayMicroseconds(5);
+  _lastAddress = address;
+  _addressValid = true;
 }
 
 /**
@@ -126,11 +167,15 @@ void HY62252A::setAddress(uint16_t address)
  */
 void HY62252A::setDataBusMode(uint8_t mode)
 {
-  Logger::log(ULTRA, "setDataBusMode(): " + String(mode));
+  if (mode == _dataBusMode)
+  {
+    return; // Already in the requested mode, skip the pinMode calls
+  }
   for (int i = 0; i < 8; i++)
   {
     pinMode(_data_pins[i], mode); // mode will now be 0x0 for INPUT or 0x1 for OUTPUT
   }
+  _dataBusMode = mode;
 }
 
 /**
@@ -140,7 +185,6 @@ void HY62252A::setDataBusMode(uint8_t mode)
  */
 void HY62252A::writeDataBus(uint8_t data)
 {
-  Logger::log(ULTRA, "writeDataBus(): " + String(data));
   for (int i = 0; i < 8; i++)
   {
     digitalWrite(_data_pins[i], (data >> i) & 1);
@@ -154,7 +198,6 @@ void HY62252A::writeDataBus(uint8_t data)
  */
 uint8_t HY62252A::readDataBus()
 {
-  Logger::log(ULTRA, "HY622 wrapper: readDataBus()");
   uint8_t data = 0;
   for (int i = 0; i < 8; i++)
   {
@@ -181,7 +224,9 @@ void HY62252A::writeByte(uint16_t address, uint8_t data)
   delayMicroseconds(15);
   digitalWrite(_we_pin, HIGH);
   digitalWrite(_ce_pin, HIGH);
-  // #if LOG_LEVEL >= TRACE
+  // Read-after-write verify only when its result can be logged, use
+  // SramIntegrity for checking data without paying this on every byte.
+#if LOG_LEVEL >= 3
   uint8_t redData = readByte(address);
   if (redData == data)
   {
@@ -191,7 +236,7 @@ void HY62252A::writeByte(uint16_t address, uint8_t data)
   {
     Logger::trace("----------------HY622 wrapper: Data mismatch: " + String(data) + " != " + String(redData));
   }
-  // #endif
+#endif
 }
 
 /**
@@ -218,6 +263,10 @@ uint8_t HY62252A::readByte(uint16_t address)
 
 /**
  * Writes a block of data to SRAM starting from the specified address.
+ * This is the burst path: the data bus stays in output mode and /CE stays
+ * low for the whole block, only changed address registers are shifted out,
+ * and there is no read-after-write verify per byte. It does not log or
+ * allocate, so SramTransferQueue::poll() may run it from an ISR.
  *
  * @param startAddress The start address.
  * @param data Pointer to the data to write.
@@ -225,15 +274,28 @@ uint8_t HY62252A::readByte(uint16_t address)
  */
 void HY62252A::writeBlock(uint16_t startAddress, const uint8_t *data, uint16_t length)
 {
-  Logger::trace("Writing block of length: " + String(length) + " to address: " + String(startAddress));
+  if (length == 0)
+  {
+    return;
+  }
+  setDataBusMode(OUTPUT);
+  digitalWrite(_ce_pin, LOW);
   for (uint16_t i = 0; i < length; i++)
   {
-    writeByte(startAddress + i, data[i]);
+    latchAddress(startAddress + i);
+    writeDataBus(data[i]);
+    digitalWrite(_we_pin, LOW);
+    delayMicroseconds(1);
+    digitalWrite(_we_pin, HIGH);
   }
+  digitalWrite(_ce_pin, HIGH);
 }
 
 /**
  * Reads a block of data from SRAM starting from the specified address.
+ * This is the burst path: /CE and /OE stay low for the whole block and
+ * only the address changes between bytes. Like writeBlock() it does not
+ * log or allocate.
  *
  * @param startAddress The start address.
  * @param buffer Pointer to the buffer to store the data.
@@ -241,11 +303,49 @@ void HY62252A::writeBlock(uint16_t startAddress, const uint8_t *data, uint16_t l
  */
 void HY62252A::readBlock(uint16_t startAddress, uint8_t *buffer, uint16_t length)
 {
-  Logger::trace("Reading block of length: " + String(length) + " from address: " + String(startAddress));
+  if (length == 0)
+  {
+    return;
+  }
+  setDataBusMode(INPUT);
+  digitalWrite(_ce_pin, LOW);
+  digitalWrite(_oe_pin, LOW);
   for (uint16_t i = 0; i < length; i++)
   {
-    buffer[i] = readByte(startAddress + i);
+    latchAddress(startAddress + i);
+    delayMicroseconds(1);
+    buffer[i] = readDataBus();
+  }
+  digitalWrite(_oe_pin, HIGH);
+  digitalWrite(_ce_pin, HIGH);
+}
+
+/**
+ * Switches which /CE pin is strobed by the read and write cycles. Used when
+ * several chips share the address and data buses and only differ in /CE.
+ * The pin is expected to be configured as an output and held HIGH already.
+ *
+ * @param ce_pin Chip Enable control pin of the chip to talk to.
+ */
+void HY62252A::setChipEnablePin(uint8_t ce_pin)
+{
+  _ce_pin = ce_pin;
+}
+
+/**
+ * Whether a register shares the latch, clock and data pins of the address
+ * registers without being one of them. Shifting it on its own would push a
+ * byte through the address chain, and the address latches never shift it.
+ *
+ * @param reg The register to check.
+ */
+bool HY62252A::sharesAddressChain(const ShiftRegister74HC595 *reg) const
+{
+  if (!reg || isAddressRegister(reg) || !_shiftRegister1)
+  {
+    return false;
   }
+  return reg->sharesPinsWith(_shiftRegister1) || reg->sharesPinsWith(_shiftRegister2);
 }
 
 /**
@@ -0,0 +1,287 @@
+#include "Hd44780Pcf8574.h"
+
+// PCF8574 outputs
+#define LCD_RS 0x01
+#define LCD_EN 0x04
+#define LCD_BACKLIGHT 0x08
+
+// HD44780 instructions and flags
+#define LCD_CLEAR 0x01
+#define LCD_HOME 0x02
+#define LCD_ENTRY_MODE 0x04
+#define LCD_ENTRY_LEFT 0x02
+#define LCD_DISPLAY_CONTROL 0x08
+#define LCD_DISPLAY_ON 0x04
+#define LCD_CURSOR_ON 0x02
+#define LCD_BLINK_ON 0x01
+#define LCD_FUNCTION_SET 0x20
+#define LCD_TWO_LINES 0x08
+#define LCD_SET_CGRAM 0x40
+#define LCD_SET_DDRAM 0x80
+
+// Execution time of clear and home
+#define LCD_SLOW_COMMAND_US 1600
+
+/**
+ * Constructor.
+ *
+ * @param address I2C address of the PCF8574 (usually 0x27 or 0x3F).
+ * @param cols Number of columns.
+ * @param rows Number of rows.
+ */
+Hd44780Pcf8574::Hd44780Pcf8574(uint8_t address, uint8_t cols, uint8_t rows)
+    : _address(address), _cols(cols), _rows(rows), _backlight(LCD_BACKLIGHT),
+      _displayControl(LCD_DISPLAY_ON), _current(0), _buffer(_buffers[0]), _length(0), _busyUntil(0)
+{
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    _transactions[i].done = true;
+  }
+}
+
+/**
+ * Initializes the controller into 4-bit mode, whatever mode it was in.
+ *
+ * The three 0x3 nibbles and their waits are the datasheet's
+ * "initialization by instruction" sequence.
+ */
+void Hd44780Pcf8574::begin()
+{
+  I2cBus::begin(I2cBus::getClock());
+
+  // The controller needs 40 ms after Vcc rises
+  if (millis() < 50)
+  {
+    delay(50 - millis());
+  }
+  _buffer[_length++] = _backlight;
+  busyFor(0);
+
+  sendNibble(0x30, 0);
+  busyFor(4500);
+  sendNibble(0x30, 0);
+  busyFor(150);
+  sendNibble(0x30, 0);
+  busyFor(150);
+  sendNibble(0x20, 0);
+  busyFor(150);
+
+  command(LCD_FUNCTION_SET | (_rows > 1 ? LCD_TWO_LINES : 0));
+  command(LCD_DISPLAY_CONTROL | _displayControl);
+  command(LCD_ENTRY_MODE | LCD_ENTRY_LEFT);
+  clear();
+}
+
+void Hd44780Pcf8574::command(uint8_t value)
+{
+  send(value, 0);
+}
+
+void Hd44780Pcf8574::write(uint8_t character)
+{
+  send(character, LCD_RS);
+}
+
+void Hd44780Pcf8574::write(const uint8_t *characters, uint8_t length)
+{
+  while (length--)
+  {
+    send(*characters++, LCD_RS);
+  }
+}
+
+void Hd44780Pcf8574::clear()
+{
+  command(LCD_CLEAR);
+  busyFor(LCD_SLOW_COMMAND_US);
+}
+
+void Hd44780Pcf8574::home()
+{
+  command(LCD_HOME);
+  busyFor(LCD_SLOW_COMMAND_US);
+}
+
+/**
+ * Moves the cursor. Rows 2 and 3 of 4-row displays continue rows 0 and 1
+ * in DDRAM, so their offset depends on the width.
+ *
+ * @param col The column number (0-based index).
+ * @param row The row number (0-based index).
+ */
+void Hd44780Pcf8574::setCursor(uint8_t col, uint8_t row)
+{
+  if (row >= _rows)
+  {
+    row = _rows - 1;
+  }
+  uint8_t offset = (row & 1) ? 0x40 : 0x00;
+  if (row >= 2)
+  {
+    offset += _cols;
+  }
+  command(LCD_SET_DDRAM | (offset + col));
+}
+
+void Hd44780Pcf8574::display()
+{
+  _displayControl |= LCD_DISPLAY_ON;
+  command(LCD_DISPLAY_CONTROL | _displayControl);
+}
+
+void Hd44780Pcf8574::noDisplay()
+{
+  _displayControl &= ~LCD_DISPLAY_ON;
+  command(LCD_DISPLAY_CONTROL | _displayControl);
+}
+
+void Hd44780Pcf8574::cursor()
+{
+  _displayControl |= LCD_CURSOR_ON;
+  command(LCD_DISPLAY_CONTROL | _displayControl);
+}
+
+void Hd44780Pcf8574::noCursor()
+{
+  _displayControl &= ~LCD_CURSOR_ON;
+  command(LCD_DISPLAY_CONTROL | _displayControl);
+}
+
+void Hd44780Pcf8574::blink()
+{
+  _displayControl |= LCD_BLINK_ON;
+  command(LCD_DISPLAY_CONTROL | _displayControl);
+}
+
+void Hd44780Pcf8574::noBlink()
+{
+  _displayControl &= ~LCD_BLINK_ON;
+  command(LCD_DISPLAY_CONTROL | _displayControl);
+}
+
+/**
+ * Turns the backlight on. The backlight bit rides along with every
+ * expander byte, so this only needs one byte of its own.
+ */
+void Hd44780Pcf8574::backlight()
+{
+  _backlight = LCD_BACKLIGHT;
+  if (_length >= I2C_WIRE_BUFFER)
+  {
+    flush();
+  }
+  _buffer[_length++] = _backlight;
+}
+
+void Hd44780Pcf8574::noBacklight()
+{
+  _backlight = 0;
+  if (_length >= I2C_WIRE_BUFFER)
+  {
+    flush();
+  }
+  _buffer[_length++] = _backlight;
+}
+
+/**
+ * Stores a glyph in CGRAM. The DDRAM address is lost, so callers must
+ * set the cursor again before writing text.
+ *
+ * @param slot CGRAM slot 0-7, shown by writing character code slot.
+ * @param pattern 8 rows, top first, low 5 bits used.
+ */
+void Hd44780Pcf8574::createChar(uint8_t slot, const uint8_t pattern[8])
+{
+  command(LCD_SET_CGRAM | ((slot & 0x07) << 3));
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    write(pattern[i]);
+  }
+}
+
+/**
+ * Queues the collected expander bytes as one transmission, after the
+ * controller has finished any slow command, and runs the bus once so they
+ * normally go out right away. Collecting continues in the other buffer; if
+ * that one is still queued, the bus is run until it has been sent.
+ */
+void Hd44780Pcf8574::flush()
+{
+  if (_length == 0)
+  {
+    return;
+  }
+  waitReady();
+
+  I2cTransaction &transaction = _transactions[_current];
+  transaction.address = _address;
+  transaction.header = nullptr;
+  transaction.headerLength = 0;
+  transaction.writeData = _buffer;
+  transaction.writeLength = _length;
+  transaction.readBuffer = nullptr;
+  transaction.readLength = 0;
+  transaction.priority = I2cBus::PRIORITY_DISPLAY;
+  transaction.batchable = true;
+  transaction.callback = nullptr;
+  transaction.context = nullptr;
+  if (!I2cBus::submit(&transaction))
+  {
+    I2cBus::write(_address, _buffer, _length);
+  }
+
+  _current ^= 1;
+  _buffer = _buffers[_current];
+  _length = 0;
+  I2cBus::poll();
+  while (!_transactions[_current].done)
+  {
+    I2cBus::poll();
+  }
+}
+
+void Hd44780Pcf8574::sync()
+{
+  flush();
+  while (!_transactions[0].done || !_transactions[1].done)
+  {
+    I2cBus::poll();
+  }
+}
+
+void Hd44780Pcf8574::send(uint8_t value, uint8_t mode)
+{
+  sendNibble(value & 0xF0, mode);
+  sendNibble(value << 4, mode);
+}
+
+/**
+ * Queues a nibble as two expander bytes: E high with the data, then E low.
+ * The controller latches the nibble on the falling edge of E.
+ */
+void Hd44780Pcf8574::sendNibble(uint8_t value, uint8_t mode)
+{
+  if (_length + 2 > I2C_WIRE_BUFFER)
+  {
+    flush();
+  }
+  uint8_t bits = (value & 0xF0) | mode | _backlight;
+  _buffer[_length++] = bits | LCD_EN;
+  _buffer[_length++] = bits;
+}
+
+void Hd44780Pcf8574::waitReady()
+{
+  long left = (long)(_busyUntil - micros());
+  if (left > 0)
+  {
+    delayMicroseconds(left);
+  }
+}
+
+void Hd44780Pcf8574::busyFor(uint16_t busyMicros)
+{
+  // The busy time starts when the command has actually been sent
+  sync();
+  _busyUntil = micros() + busyMicros;
+}
@@ -0,0 +1,335 @@
+#include "I2cBus.h"
+#include "logger.h"
+
+bool I2cBus::_started = false;
+uint32_t I2cBus::_clockHz = 100000;
+I2cTransaction *I2cBus::_queue = nullptr;
+uint8_t I2cBus::_queueDepth = 0;
+volatile bool I2cBus::_busy = false;
+I2cBus::DeviceStats I2cBus::_stats[I2C_BUS_MAX_DEVICES];
+uint8_t I2cBus::_statsCount = 0;
+
+/**
+ * Starts Wire and sets the clock. Later calls only change the clock.
+ *
+ * @param clockHz Bus clock in Hz.
+ */
+void I2cBus::begin(uint32_t clockHz)
+{
+  if (!_started)
+  {
+    Wire.begin();
+    _started = true;
+  }
+  setClock(clockHz);
+}
+
+void I2cBus::setClock(uint32_t clockHz)
+{
+  _clockHz = clockHz;
+  if (_started)
+  {
+    Wire.setClock(clockHz);
+  }
+}
+
+/**
+ * Sends header and data in one transmission, e.g. a memory address
+ * followed by the bytes to store, without copying them together first.
+ *
+ * @param address The device address.
+ * @param header First bytes to send, may be nullptr.
+ * @param headerLength Number of header bytes.
+ * @param data Bytes to send after the header, may be nullptr.
+ * @param dataLength Number of data bytes.
+ * @return The endTransmission() code, 0 on success.
+ */
+uint8_t I2cBus::write(uint8_t address, const uint8_t *header, uint8_t headerLength, const uint8_t *data, uint8_t dataLength)
+{
+  if (!_started)
+  {
+    begin(_clockHz);
+  }
+  unsigned long start = micros();
+  Wire.beginTransmission(address);
+  if (headerLength > 0)
+  {
+    Wire.write(header, headerLength);
+  }
+  if (dataLength > 0)
+  {
+    Wire.write(data, dataLength);
+  }
+  uint8_t status = Wire.endTransmission();
+  account(address, start, headerLength + dataLength);
+  return status;
+}
+
+/**
+ * Requests bytes from a device.
+ *
+ * @param address The device address.
+ * @param buffer Buffer for the data.
+ * @param length Number of bytes, at most I2C_WIRE_BUFFER.
+ * @return The number of bytes received.
+ */
+uint8_t I2cBus::read(uint8_t address, uint8_t *buffer, uint8_t length)
+{
+  if (!_started)
+  {
+    begin(_clockHz);
+  }
+  unsigned long start = micros();
+  uint8_t received = Wire.requestFrom(address, length);
+  for (uint8_t i = 0; i < received; i++)
+  {
+    buffer[i] = Wire.read();
+  }
+  account(address, start, received);
+  return received;
+}
+
+/**
+ * Sends an address-only transmission.
+ *
+ * @param address The device address.
+ * @return true if the device acknowledged.
+ */
+bool I2cBus::probe(uint8_t address)
+{
+  return write(address, nullptr, 0) == 0;
+}
+
+/**
+ * Queues a transaction behind every queued one of the same or higher priority.
+ *
+ * @param transaction The descriptor, filled in by the caller.
+ * @return false if it is invalid or already queued.
+ */
+bool I2cBus::submit(I2cTransaction *transaction)
+{
+  if (!transaction || transaction->headerLength + transaction->writeLength > I2C_WIRE_BUFFER ||
+      transaction->readLength > I2C_WIRE_BUFFER)
+  {
+    return false;
+  }
+  for (I2cTransaction *queued = _queue; queued; queued = queued->next)
+  {
+    if (queued == transaction)
+    {
+      return false;
+    }
+  }
+
+  transaction->status = 0;
+  transaction->done = false;
+  I2cTransaction **link = &_queue;
+  while (*link && (*link)->priority >= transaction->priority)
+  {
+    link = &(*link)->next;
+  }
+  transaction->next = *link;
+  *link = transaction;
+  _queueDepth++;
+  return true;
+}
+
+/**
+ * Runs the first queued transaction.
+ *
+ * If it is a batchable write, later batchable writes to the same device
+ * that fit in the Wire buffer are sent in the same transmission. The search
+ * stops at the first other transaction to that device, so a device always
+ * sees its transactions in queue order.
+ *
+ * @return false if the queue was empty or poll() is already running.
+ */
+bool I2cBus::poll()
+{
+  if (_busy || !_queue)
+  {
+    return false;
+  }
+  _busy = true;
+  if (!_started)
+  {
+    begin(_clockHz);
+  }
+
+  I2cTransaction *transaction = _queue;
+  _queue = transaction->next;
+  _queueDepth--;
+
+  unsigned long start = micros();
+  uint16_t bytes = 0;
+  uint8_t status = 0;
+  I2cTransaction *batched = nullptr;
+
+  uint8_t writeLength = transaction->headerLength + transaction->writeLength;
+  if (writeLength > 0 || transaction->readLength == 0)
+  {
+    Wire.beginTransmission(transaction->address);
+    sendWrite(transaction);
+    bytes += writeLength;
+
+    if (transaction->batchable && transaction->readLength == 0)
+    {
+      uint8_t room = I2C_WIRE_BUFFER - writeLength;
+      I2cTransaction **tail = &batched;
+      I2cTransaction **link = &_queue;
+      while (*link)
+      {
+        I2cTransaction *other = *link;
+        if (other->address != transaction->address)
+        {
+          link = &other->next;
+          continue;
+        }
+        uint8_t otherLength = other->headerLength + other->writeLength;
+        if (!other->batchable || other->readLength > 0 || otherLength > room)
+        {
+          break;
+        }
+        sendWrite(other);
+        room -= otherLength;
+        bytes += otherLength;
+        *link = other->next;
+        _queueDepth--;
+        other->next = nullptr;
+        *tail = other;
+        tail = &other->next;
+      }
+    }
+
+    // Repeated start when a read follows
+    status = Wire.endTransmission(transaction->readLength == 0);
+  }
+
+  if (status == 0 && transaction->readLength > 0)
+  {
+    uint8_t received = Wire.requestFrom(transaction->address, transaction->readLength);
+    for (uint8_t i = 0; i < received; i++)
+    {
+      transaction->readBuffer[i] = Wire.read();
+    }
+    bytes += received;
+    if (received != transaction->readLength)
+    {
+      status = SHORT_READ;
+    }
+  }
+
+  account(transaction->address, start, bytes);
+  complete(transaction, status);
+  while (batched)
+  {
+    I2cTransaction *next = batched->next;
+    complete(batched, status);
+    batched = next;
+  }
+  _busy = false;
+  return true;
+}
+
+void I2cBus::drain()
+{
+  while (poll())
+  {
+  }
+}
+
+uint32_t I2cBus::getBusMicros(uint8_t address)
+{
+  DeviceStats *stats = findStats(address);
+  return stats ? stats->busMicros : 0;
+}
+
+uint32_t I2cBus::getTransactions(uint8_t address)
+{
+  DeviceStats *stats = findStats(address);
+  return stats ? stats->transactions : 0;
+}
+
+uint32_t I2cBus::getBytes(uint8_t address)
+{
+  DeviceStats *stats = findStats(address);
+  return stats ? stats->bytes : 0;
+}
+
+void I2cBus::resetStats()
+{
+  _statsCount = 0;
+}
+
+/**
+ * Logs bus time, transactions and bytes of every device seen so far.
+ */
+void I2cBus::printStats()
+{
+  for (uint8_t i = 0; i < _statsCount; i++)
+  {
+    Logger::info("I2C 0x" + String(_stats[i].address, HEX) + ": " + String(_stats[i].busMicros) + " us, " +
+                 String(_stats[i].transactions) + " transactions, " + String(_stats[i].bytes) + " bytes");
+  }
+}
+
+/**
+ * Charges a transaction to a device. Devices beyond I2C_BUS_MAX_DEVICES are not tracked.
+ *
+ * @param address The device address.
+ * @param start micros() when the transaction started.
+ * @param bytes Data bytes moved (not counting the address byte).
+ */
+void I2cBus::account(uint8_t address, unsigned long start, uint16_t bytes)
+{
+  DeviceStats *stats = findStats(address);
+  if (!stats)
+  {
+    if (_statsCount >= I2C_BUS_MAX_DEVICES)
+    {
+      return;
+    }
+    stats = &_stats[_statsCount++];
+    stats->address = address;
+    stats->busMicros = 0;
+    stats->transactions = 0;
+    stats->bytes = 0;
+  }
+  stats->busMicros += micros() - start;
+  stats->transactions++;
+  stats->bytes += bytes;
+}
+
+I2cBus::DeviceStats *I2cBus::findStats(uint8_t address)
+{
+  for (uint8_t i = 0; i < _statsCount; i++)
+  {
+    if (_stats[i].address == address)
+    {
+      return &_stats[i];
+    }
+  }
+  return nullptr;
+}
+
+void I2cBus::sendWrite(const I2cTransaction *transaction)
+{
+  if (transaction->headerLength > 0)
+  {
+    Wire.write(transaction->header, transaction->headerLength);
+  }
+  if (transaction->writeLength > 0)
+  {
+    Wire.write(transaction->writeData, transaction->writeLength);
+  }
+}
+
+void I2cBus::complete(I2cTransaction *transaction, uint8_t status)
+{
+  transaction->status = status;
+  transaction->done = true;
+  if (transaction->callback)
+  {
+    transaction->callback(transaction, transaction->context);
+  }
+}
@@ -1,40 +1,62 @@
 #include "LCD1602IIC.h"
+#include "NumberFormat.h"
 
 /**
  * Constructor
  *
  * Initializes the LCD1602IIC object with the specified I2C address,
  * number of columns, and number of rows. The constructor also initializes
- * the underlying LiquidCrystal_I2C object.
+ * the underlying Hd44780Pcf8574 object.
  *
  * @param lcdAddr The I2C address of the LCD screen (default is 0x27).
  * @param lcdCols The number of columns on the LCD screen (default is 16).
  * @param lcdRows The number of rows on the LCD screen (default is 2).
  */
 LCD1602IIC::LCD1602IIC(uint8_t lcdAddr, uint8_t lcdCols, uint8_t lcdRows)
-    : lcd(lcdAddr, lcdCols, lcdRows), cols(lcdCols), rows(lcdRows) {}
+    : lcd(lcdAddr, lcdCols, lcdRows), cols(lcdCols), rows(lcdRows),
+      cursorCol(0), cursorRow(0), lcdCol(0xFF), lcdRow(0xFF), underline(false), blinking(false), scanPosition(0),
+      glyphClock(0), glyphAssigned(0), glyphPending(0), glyphUploads(0)
+{
+  frame = new uint8_t[cols * rows];
+  shown = new uint8_t[cols * rows];
+  memset(frame, ' ', cols * rows);
+  memset(shown, ' ', cols * rows);
+}
+
+LCD1602IIC::~LCD1602IIC()
+{
+  delete[] frame;
+  delete[] shown;
+}
 
 /**
  * begin
  *
- * Initializes the LCD by calling the begin() method of the LiquidCrystal_I2C
- * object. This method also turns on the backlight by default.
+ * Initializes the LCD by calling the begin() method of the Hd44780Pcf8574
+ * object, which also starts the shared I2C bus and clears the screen.
+ * This method also turns on the backlight by default.
  */
 void LCD1602IIC::begin()
 {
-  lcd.begin(cols, rows); // Initialize the LCD screen
-  lcd.backlight();       // Turn on the backlight
+  lcd.begin();     // Initialize the LCD screen, it starts out blank like the buffers
+  lcd.backlight(); // Turn on the backlight
+  lcd.flush();
+  memset(shown, ' ', cols * rows);
+  lcdCol = 0;
+  lcdRow = 0;
 }
 
 /**
  * clear
  *
- * Clears all characters from the display and resets the cursor position
- * to the top-left corner (0, 0).
+ * Fills the frame buffer with spaces and resets the cursor position
+ * to the top-left corner (0, 0). The display changes on render().
  */
 void LCD1602IIC::clear()
 {
-  lcd.clear(); // Clear the display
+  memset(frame, ' ', cols * rows);
+  cursorCol = 0;
+  cursorRow = 0;
 }
 
 /**
@@ -44,7 +66,8 @@ void LCD1602IIC::clear()
  */
 void LCD1602IIC::home()
 {
-  lcd.home(); // Set cursor to (0, 0)
+  cursorCol = 0;
+  cursorRow = 0;
 }
 
 /**
@@ -61,7 +84,8 @@ void LCD1602IIC::setCursor(uint8_t col, uint8_t row)
 {
   if (col < cols && row < rows)
   {
-    lcd.setCursor(col, row); // Set cursor to the specified position
+    cursorCol = col;
+    cursorRow = row;
   }
 }
 
@@ -73,6 +97,7 @@ void LCD1602IIC::setCursor(uint8_t col, uint8_t row)
 void LCD1602IIC::backlight()
 {
   lcd.backlight(); // Enable backlight
+  lcd.flush();
 }
 
 /**
@@ -83,6 +108,7 @@ void LCD1602IIC::backlight()
 void LCD1602IIC::noBacklight()
 {
   lcd.noBacklight(); // Disable backlight
+  lcd.flush();
 }
 
 /**
@@ -94,7 +120,10 @@ void LCD1602IIC::noBacklight()
  */
 void LCD1602IIC::print(const char *message)
 {
-  lcd.print(message); // Print C-string to LCD
+  while (*message)
+  {
+    write((uint8_t)*message++);
+  }
 }
 
 /**
@@ -106,7 +135,7 @@ void LCD1602IIC::print(const char *message)
  */
 void LCD1602IIC::print(const String &message)
 {
-  lcd.print(message); // Print String object to LCD
+  print(message.c_str());
 }
 
 /**
@@ -118,7 +147,9 @@ void LCD1602IIC::print(const String &message)
  */
 void LCD1602IIC::print(int number)
 {
-  lcd.print(number); // Print integer to LCD
+  char text[NumberFormat::INT_SIZE];
+  NumberFormat::formatInt(text, sizeof(text), number);
+  print(text);
 }
 
 /**
@@ -131,7 +162,62 @@ void LCD1602IIC::print(int number)
  */
 void LCD1602IIC::print(float number, int decimals)
 {
-  lcd.print(number, decimals); // Print float to LCD with specified decimal places
+  char text[NumberFormat::FLOAT_SIZE];
+  NumberFormat::formatFloat(text, sizeof(text), number, decimals < 0 ? 0 : decimals);
+  print(text);
+}
+
+/**
+ * printPadded
+ *
+ * Prints an integer right-aligned in a fixed-width field, so a changing
+ * value overwrites its old digits instead of leaving some behind.
+ *
+ * @param number The integer to print.
+ * @param width Field width in characters.
+ * @param pad Padding character, '0' for leading zeros.
+ */
+void LCD1602IIC::printPadded(int32_t number, uint8_t width, char pad)
+{
+  char text[NUMBER_FIELD_SIZE];
+  uint8_t length = NumberFormat::formatInt(text, sizeof(text), number, width, pad);
+  printField(text, length, width);
+}
+
+/**
+ * printPadded
+ *
+ * Prints a floating-point number right-aligned in a fixed-width field.
+ *
+ * @param number The number to print.
+ * @param decimals The number of decimal places.
+ * @param width Field width in characters.
+ * @param pad Padding character, '0' for leading zeros.
+ */
+void LCD1602IIC::printPadded(float number, uint8_t decimals, uint8_t width, char pad)
+{
+  char text[NUMBER_FIELD_SIZE];
+  uint8_t length = NumberFormat::formatFloat(text, sizeof(text), number, decimals, width, pad);
+  printField(text, length, width);
+}
+
+/**
+ * printField
+ *
+ * Prints a formatted number, or fills the field with '*' if it was too
+ * long for the field or the buffer.
+ */
+void LCD1602IIC::printField(const char *text, uint8_t length, uint8_t width)
+{
+  if (length > 0 && (width == 0 || length <= width))
+  {
+    print(text);
+    return;
+  }
+  while (width-- > 0)
+  {
+    write('*');
+  }
 }
 
 /**
@@ -142,6 +228,8 @@ void LCD1602IIC::print(float number, int decimals)
 void LCD1602IIC::cursor()
 {
   lcd.cursor(); // Show underline cursor
+  lcd.flush();
+  underline = true;
 }
 
 /**
@@ -152,6 +240,8 @@ void LCD1602IIC::cursor()
 void LCD1602IIC::noCursor()
 {
   lcd.noCursor(); // Hide underline cursor
+  lcd.flush();
+  underline = false;
 }
 
 /**
@@ -162,6 +252,8 @@ void LCD1602IIC::noCursor()
 void LCD1602IIC::blink()
 {
   lcd.blink(); // Enable blinking cursor
+  lcd.flush();
+  blinking = true;
 }
 
 /**
@@ -172,4 +264,290 @@ void LCD1602IIC::blink()
 void LCD1602IIC::noBlink()
 {
   lcd.noBlink(); // Disable blinking cursor
+  lcd.flush();
+  blinking = false;
+}
+
+/**
+ * write
+ *
+ * Puts one character into the frame buffer at the cursor and advances the
+ * cursor. Like the display itself, text does not wrap to the next row.
+ *
+ * @param character The character code.
+ */
+void LCD1602IIC::write(uint8_t character)
+{
+  if (cursorCol < cols)
+  {
+    frame[cursorRow * cols + cursorCol] = character;
+    cursorCol++;
+  }
+}
+
+/**
+ * render
+ *
+ * Sends every frame buffer cell that differs from the display. The display
+ * advances its cursor after every character, so a run of changed cells
+ * needs one cursor move; a single unchanged cell between two changed ones
+ * is sent along, since that costs the same as a cursor move. If the
+ * cursor is visible it is put back at the frame buffer cursor afterwards.
+ *
+ * @return The number of cells sent.
+ */
+uint8_t LCD1602IIC::render()
+{
+  uint8_t sent = 0;
+  drawChanged(0xFFFFFFFFUL, sent);
+  return sent;
+}
+
+/**
+ * update
+ *
+ * Time-sliced render(): sends changed cells until the next one would not
+ * fit in the budget, and carries on from that cell on the next call. Each
+ * call sends at least one changed cell, so a static frame is complete
+ * after at most cols * rows calls, and usually after a few.
+ *
+ * The time of a cell is estimated from the bus clock (four expander bytes
+ * per character, four more for a cursor move) plus the time already spent
+ * on transmissions the driver had to send during this call.
+ *
+ * @param budgetMicros Time this call may spend on the display.
+ * @return true if the display now matches the frame buffer.
+ */
+bool LCD1602IIC::update(uint32_t budgetMicros)
+{
+  uint8_t sent = 0;
+  return drawChanged(budgetMicros, sent);
+}
+
+/**
+ * drawChanged
+ *
+ * Scans the frame buffer once, starting where the previous call stopped,
+ * and sends the changed cells that fit in the budget.
+ *
+ * @param budgetMicros Time budget, 0xFFFFFFFF for no limit.
+ * @param sent Incremented for every cell sent.
+ * @return true if every changed cell was sent.
+ */
+bool LCD1602IIC::drawChanged(uint32_t budgetMicros, uint8_t &sent)
+{
+  unsigned long start = micros();
+  uint16_t byteMicros = 9000000UL / I2cBus::getClock() + 1; // 9 clocks per byte with the ACK
+  uint16_t cells = (uint16_t)cols * rows;
+  bool progress = false;
+
+  // Glyphs first, the cells may show them
+  for (uint8_t slot = 0; slot < GLYPH_SLOTS && glyphPending; slot++)
+  {
+    if (!(glyphPending & (1 << slot)))
+    {
+      continue;
+    }
+    uint32_t cost = 9 * 4 * byteMicros; // CGRAM address and 8 rows
+    uint32_t spent = (micros() - start) + (uint32_t)lcd.queued() * byteMicros;
+    if (progress && budgetMicros != 0xFFFFFFFFUL && spent + cost > budgetMicros)
+    {
+      lcd.flush();
+      return false;
+    }
+    lcd.createChar(slot, glyphs[slot]);
+    glyphPending &= ~(1 << slot);
+    glyphUploads++;
+    progress = true;
+    // Writing CGRAM moved the display's address counter
+    lcdCol = 0xFF;
+    lcdRow = 0xFF;
+  }
+
+  bool complete = true;
+  for (uint16_t checked = 0; checked < cells; checked++)
+  {
+    uint16_t index = scanPosition;
+    if (frame[index] != shown[index])
+    {
+      uint8_t row = index / cols;
+      uint8_t col = index % cols;
+      bool adjacent = lcdRow == row && (lcdCol == col || lcdCol + 1 == col);
+      uint32_t cost = (adjacent ? 4 : 8) * byteMicros;
+      uint32_t spent = (micros() - start) + (uint32_t)lcd.queued() * byteMicros;
+      if (progress && budgetMicros != 0xFFFFFFFFUL && spent + cost > budgetMicros)
+      {
+        complete = false;
+        break;
+      }
+
+      // Bridge a one-cell gap instead of moving the cursor
+      if (lcdRow == row && lcdCol + 1 == col)
+      {
+        lcd.write(frame[index - 1]);
+        shown[index - 1] = frame[index - 1];
+        lcdCol++;
+        sent++;
+      }
+      moveLcdCursor(col, row);
+      lcd.write(frame[index]);
+      shown[index] = frame[index];
+      lcdCol++;
+      sent++;
+      progress = true;
+    }
+    scanPosition = (scanPosition + 1) % cells;
+  }
+
+  if (complete && (underline || blinking) && cursorCol < cols)
+  {
+    moveLcdCursor(cursorCol, cursorRow);
+  }
+  lcd.flush();
+  return complete;
+}
+
+/**
+ * invalidate
+ *
+ * Marks every cell as unknown, so the next render() redraws the screen.
+ */
+void LCD1602IIC::invalidate()
+{
+  for (uint16_t i = 0; i < (uint16_t)cols * rows; i++)
+  {
+    shown[i] = ~frame[i];
+  }
+  lcdCol = 0xFF;
+  lcdRow = 0xFF;
+}
+
+/**
+ * glyph
+ *
+ * Returns the slot already holding the pattern, or assigns the least
+ * recently used slot that no frame buffer cell shows. Slots shown on the
+ * display but not in the frame may be reassigned: those cells are about
+ * to be overwritten by the next render() anyway.
+ *
+ * @param pattern 8 rows, top first, low 5 bits used.
+ * @return The slot, -1 if every slot is shown by the frame.
+ */
+int8_t LCD1602IIC::glyph(const uint8_t pattern[8])
+{
+  if (++glyphClock == 0)
+  {
+    // Stamp wrapped, restart the LRU order
+    memset(glyphLastUse, 0, sizeof(glyphLastUse));
+    glyphClock = 1;
+  }
+
+  int8_t victim = -1;
+  for (uint8_t slot = 0; slot < GLYPH_SLOTS; slot++)
+  {
+    if (glyphAssigned & (1 << slot))
+    {
+      if (memcmp(glyphs[slot], pattern, 8) == 0)
+      {
+        glyphLastUse[slot] = glyphClock;
+        return slot;
+      }
+    }
+    else if (victim < 0 || (glyphAssigned & (1 << victim)))
+    {
+      victim = slot; // Free slots go first
+    }
+  }
+
+  if (victim < 0)
+  {
+    for (uint8_t slot = 0; slot < GLYPH_SLOTS; slot++)
+    {
+      if ((victim < 0 || glyphLastUse[slot] < glyphLastUse[victim]) && !glyphInFrame(slot))
+      {
+        victim = slot;
+      }
+    }
+    if (victim < 0)
+    {
+      return -1;
+    }
+  }
+
+  memcpy(glyphs[victim], pattern, 8);
+  glyphAssigned |= 1 << victim;
+  glyphPending |= 1 << victim;
+  glyphLastUse[victim] = glyphClock;
+  return victim;
+}
+
+/**
+ * writeGlyph
+ *
+ * Writes a custom glyph at the cursor.
+ *
+ * @param pattern 8 rows, top first, low 5 bits used.
+ * @param fallback Character written if no CGRAM slot is free.
+ */
+void LCD1602IIC::writeGlyph(const uint8_t pattern[8], uint8_t fallback)
+{
+  int8_t slot = glyph(pattern);
+  write(slot < 0 ? fallback : (uint8_t)slot);
+}
+
+/**
+ * glyphInFrame
+ *
+ * Checks whether any frame buffer cell shows a CGRAM slot.
+ *
+ * @param slot The slot.
+ * @return true if the slot is in use.
+ */
+bool LCD1602IIC::glyphInFrame(uint8_t slot) const
+{
+  for (uint16_t i = 0; i < (uint16_t)cols * rows; i++)
+  {
+    if (frame[i] == slot)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * getChar
+ *
+ * Returns the frame buffer character at a cell.
+ *
+ * @param col The column number (0-based index).
+ * @param row The row number (0-based index).
+ * @return The character, 0 if the cell is off screen.
+ */
+uint8_t LCD1602IIC::getChar(uint8_t col, uint8_t row) const
+{
+  if (col >= cols || row >= rows)
+  {
+    return 0;
+  }
+  return frame[row * cols + col];
+}
+
+/**
+ * moveLcdCursor
+ *
+ * Moves the display's cursor, skipping the command if it is already there.
+ *
+ * @param col The column number (0-based index).
+ * @param row The row number (0-based index).
+ */
+void LCD1602IIC::moveLcdCursor(uint8_t col, uint8_t row)
+{
+  if (lcdCol == col && lcdRow == row)
+  {
+    return;
+  }
+  lcd.setCursor(col, row);
+  lcdCol = col;
+  lcdRow = row;
 }
@@ -0,0 +1,77 @@
+#include "LcdBarGraph.h"
+
+/**
+ * horizontal
+ *
+ * Full cells, then one partial cell with the left k of 5 pixel columns lit,
+ * then spaces.
+ */
+void LcdBarGraph::horizontal(LCD1602IIC &lcd, uint8_t col, uint8_t row, uint8_t width, float value, float maxValue)
+{
+  uint16_t filled = filledSteps(value, maxValue, (uint16_t)width * 5);
+  lcd.setCursor(col, row);
+  for (uint8_t cell = 0; cell < width; cell++)
+  {
+    uint16_t lit = filled > 5 ? 5 : filled;
+    filled -= lit;
+    if (lit == 5)
+    {
+      lcd.write(FULL_BLOCK);
+    }
+    else if (lit == 0)
+    {
+      lcd.write(' ');
+    }
+    else
+    {
+      uint8_t pattern[8];
+      memset(pattern, (0x1F << (5 - lit)) & 0x1F, sizeof(pattern));
+      lcd.writeGlyph(pattern, '|');
+    }
+  }
+}
+
+/**
+ * vertical
+ *
+ * Full cells from the bottom up, then one partial cell with its bottom k of
+ * 8 pixel rows lit, then spaces.
+ */
+void LcdBarGraph::vertical(LCD1602IIC &lcd, uint8_t col, uint8_t bottomRow, uint8_t height, float value, float maxValue)
+{
+  uint16_t filled = filledSteps(value, maxValue, (uint16_t)height * 8);
+  for (uint8_t cell = 0; cell < height && cell <= bottomRow; cell++)
+  {
+    uint16_t lit = filled > 8 ? 8 : filled;
+    filled -= lit;
+    lcd.setCursor(col, bottomRow - cell);
+    if (lit == 8)
+    {
+      lcd.write(FULL_BLOCK);
+    }
+    else if (lit == 0)
+    {
+      lcd.write(' ');
+    }
+    else
+    {
+      uint8_t pattern[8];
+      memset(pattern, 0, 8 - lit);
+      memset(pattern + 8 - lit, 0x1F, lit);
+      lcd.writeGlyph(pattern, '_');
+    }
+  }
+}
+
+uint16_t LcdBarGraph::filledSteps(float value, float maxValue, uint16_t steps)
+{
+  if (maxValue <= 0 || value <= 0)
+  {
+    return 0;
+  }
+  if (value >= maxValue)
+  {
+    return steps;
+  }
+  return (uint16_t)(value / maxValue * steps + 0.5f);
+}
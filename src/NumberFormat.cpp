@@ -0,0 +1,162 @@
+#include "NumberFormat.h"
+
+static const uint32_t POWERS_OF_TEN[10] = {1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL,
+                                           1000000UL, 10000000UL, 100000000UL, 1000000000UL};
+
+/**
+ * Formats an unsigned integer.
+ *
+ * @param buffer Destination.
+ * @param size Destination size including the terminator.
+ * @param value The value.
+ * @param base 2 to 16.
+ * @param width Minimum length, padded on the left.
+ * @param pad Padding character.
+ * @return The length, 0 if it did not fit.
+ */
+uint8_t NumberFormat::formatUnsigned(char *buffer, uint8_t size, uint32_t value, uint8_t base, uint8_t width, char pad)
+{
+  char text[33];
+  if (base < 2 || base > 16)
+  {
+    base = 10;
+  }
+  char *first = digits(text + sizeof(text), value, base);
+  return emit(buffer, size, false, first, text + sizeof(text) - first, width, pad);
+}
+
+uint8_t NumberFormat::formatInt(char *buffer, uint8_t size, int32_t value, uint8_t width, char pad)
+{
+  char text[10];
+  // Negate in unsigned arithmetic so INT32_MIN works too
+  uint32_t magnitude = value < 0 ? 0UL - (uint32_t)value : (uint32_t)value;
+  char *first = digits(text + sizeof(text), magnitude, 10);
+  return emit(buffer, size, value < 0, first, text + sizeof(text) - first, width, pad);
+}
+
+uint8_t NumberFormat::formatFixed(char *buffer, uint8_t size, int32_t scaled, uint8_t decimals, uint8_t width, char pad)
+{
+  uint32_t magnitude = scaled < 0 ? 0UL - (uint32_t)scaled : (uint32_t)scaled;
+  if (decimals > 9)
+  {
+    decimals = 9;
+  }
+  uint32_t integer = magnitude / POWERS_OF_TEN[decimals];
+  return emitFixed(buffer, size, scaled < 0, integer, magnitude - integer * POWERS_OF_TEN[decimals], decimals, width, pad);
+}
+
+/**
+ * Formats a float with a fixed number of decimals.
+ *
+ * The integer part and the rounded fraction are converted to integers
+ * separately, so large values keep all the precision a float has.
+ * |value| must stay below 2^32, otherwise "ovf" is written.
+ *
+ * @param buffer Destination.
+ * @param size Destination size including the terminator.
+ * @param value The value.
+ * @param decimals Digits after the point, at most 9.
+ * @param width Minimum length, padded on the left.
+ * @param pad Padding character.
+ * @return The length, 0 if it did not fit.
+ */
+uint8_t NumberFormat::formatFloat(char *buffer, uint8_t size, float value, uint8_t decimals, uint8_t width, char pad)
+{
+  if (isnan(value))
+  {
+    return emit(buffer, size, false, "nan", 3, width, pad == '0' ? ' ' : pad);
+  }
+  if (isinf(value))
+  {
+    return emit(buffer, size, value < 0, "inf", 3, width, pad == '0' ? ' ' : pad);
+  }
+  if (decimals > 9)
+  {
+    decimals = 9;
+  }
+
+  bool negative = value < 0;
+  float magnitude = negative ? -value : value;
+  if (magnitude >= 4294967296.0f) // 2^32
+  {
+    return emit(buffer, size, false, "ovf", 3, width, pad == '0' ? ' ' : pad);
+  }
+  uint32_t integer = (uint32_t)magnitude;
+  uint32_t fraction = (uint32_t)((magnitude - integer) * POWERS_OF_TEN[decimals] + 0.5f);
+  if (fraction >= POWERS_OF_TEN[decimals])
+  {
+    // Rounded up to the next integer
+    integer++;
+    fraction -= POWERS_OF_TEN[decimals];
+  }
+  // No "-0.00"
+  return emitFixed(buffer, size, negative && (integer | fraction) != 0, integer, fraction, decimals, width, pad);
+}
+
+char *NumberFormat::digits(char *end, uint32_t value, uint8_t base)
+{
+  char *p = end;
+  // 32-bit division is the slow part on AVR, switch to 16-bit as soon as possible
+  while (value > 0xFFFF)
+  {
+    uint8_t digit = value % base;
+    *--p = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= base;
+  }
+  uint16_t small = value;
+  do
+  {
+    uint8_t digit = small % base;
+    *--p = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    small /= base;
+  } while (small > 0);
+  return p;
+}
+
+uint8_t NumberFormat::emit(char *buffer, uint8_t size, bool negative, const char *text, uint8_t length, uint8_t width, char pad)
+{
+  uint8_t total = length + (negative ? 1 : 0);
+  uint8_t padding = width > total ? width - total : 0;
+  if (size == 0)
+  {
+    return 0;
+  }
+  if (total + padding >= size)
+  {
+    buffer[0] = '\0';
+    return 0;
+  }
+
+  char *p = buffer;
+  if (negative && pad == '0')
+  {
+    *p++ = '-';
+  }
+  memset(p, pad, padding);
+  p += padding;
+  if (negative && pad != '0')
+  {
+    *p++ = '-';
+  }
+  memcpy(p, text, length);
+  p[length] = '\0';
+  return total + padding;
+}
+
+uint8_t NumberFormat::emitFixed(char *buffer, uint8_t size, bool negative, uint32_t integer, uint32_t fraction, uint8_t decimals, uint8_t width, char pad)
+{
+  char text[20];
+  char *end = text + sizeof(text);
+  char *first = end;
+  if (decimals > 0)
+  {
+    first = digits(end, fraction, 10);
+    while (end - first < decimals)
+    {
+      *--first = '0';
+    }
+    *--first = '.';
+  }
+  first = digits(first, integer, 10);
+  return emit(buffer, size, negative, first, end - first, width, pad);
+}
@@ -0,0 +1,290 @@
+#include "PowerScheduler.h"
+#include "logger.h"
+
+#if defined(__AVR__)
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+
+// The Arduino core's millis and micros counters (wiring.c)
+extern volatile unsigned long timer0_millis;
+extern volatile unsigned long timer0_overflow_count;
+
+// CPU clocks per Timer0 overflow: prescaler 64 x 256 counts
+static const uint32_t CLOCKS_PER_TIMER0_OVERFLOW = 64UL * 256;
+
+/**
+ * Adds slept time to both core counters, so micros() stays in step with
+ * millis(). Call with interrupts off.
+ *
+ * @param sleptMillis Time spent in power-down.
+ */
+static void advanceTimer0(uint16_t sleptMillis)
+{
+  // Clocks short of a whole overflow, carried to the next call
+  static uint32_t clockRemainder = 0;
+  timer0_millis += sleptMillis;
+  clockRemainder += (uint32_t)sleptMillis * (F_CPU / 1000);
+  timer0_overflow_count += clockRemainder / CLOCKS_PER_TIMER0_OVERFLOW;
+  clockRemainder %= CLOCKS_PER_TIMER0_OVERFLOW;
+}
+
+static volatile bool watchdogFired = false;
+
+ISR(WDT_vect)
+{
+  watchdogFired = true;
+}
+#elif defined(ESP8266)
+extern "C"
+{
+#include "user_interface.h"
+}
+#endif
+
+PowerScheduler::Task PowerScheduler::_tasks[POWER_MAX_TASKS];
+uint8_t PowerScheduler::_taskCount = 0;
+int16_t PowerScheduler::_wakePin = -1;
+int PowerScheduler::_wakeMode = LOW;
+PowerTaskCallback PowerScheduler::_wakeCallback = nullptr;
+void *PowerScheduler::_wakeContext = nullptr;
+volatile bool PowerScheduler::_pinWoke = false;
+PowerSleepHook PowerScheduler::_sleepHook = nullptr;
+uint32_t PowerScheduler::_virtualMillis = 0;
+uint32_t PowerScheduler::_deepSleepThreshold = 0;
+uint64_t PowerScheduler::_awakeMicros = 0;
+uint32_t PowerScheduler::_sleepMillis = 0;
+
+void PowerScheduler::begin()
+{
+#if defined(ESP8266)
+  wifi_set_sleep_type(LIGHT_SLEEP_T);
+#endif
+  resetStats();
+}
+
+/**
+ * Adds a periodic task. Its first run is on the next runOnce().
+ *
+ * @param callback The task.
+ * @param context Passed to the callback.
+ * @param intervalMillis Time between runs.
+ * @return false if the task table is full.
+ */
+bool PowerScheduler::addTask(PowerTaskCallback callback, void *context, uint32_t intervalMillis)
+{
+  if (!callback || _taskCount >= POWER_MAX_TASKS)
+  {
+    return false;
+  }
+  Task &task = _tasks[_taskCount++];
+  task.callback = callback;
+  task.context = context;
+  task.interval = intervalMillis;
+  task.nextRun = now();
+  return true;
+}
+
+bool PowerScheduler::addBattery(BatteryManager *manager, uint32_t intervalMillis)
+{
+  return manager && addTask(sampleBattery, manager, intervalMillis);
+}
+
+/**
+ * Sets the pin that ends a sleep early.
+ *
+ * @param pin A pin with an external interrupt.
+ * @param mode LOW, CHANGE, RISING or FALLING. Only LOW wakes an AVR from power-down.
+ * @param callback Called from runOnce() (not from the interrupt) after the pin woke it.
+ * @param context Passed to the callback.
+ */
+void PowerScheduler::setWakePin(uint8_t pin, int mode, PowerTaskCallback callback, void *context)
+{
+  _wakePin = pin;
+  _wakeMode = mode;
+  _wakeCallback = callback;
+  _wakeContext = context;
+  pinMode(pin, INPUT_PULLUP);
+}
+
+/**
+ * Runs every due task, then sleeps until the next deadline.
+ *
+ * A task that fell more than one interval behind (e.g. after a long
+ * blocking call) runs once and is rescheduled from now, instead of
+ * running several times in a row to catch up.
+ *
+ * @return Why the sleep ended.
+ */
+PowerWakeSource PowerScheduler::runOnce()
+{
+  unsigned long start = micros();
+  uint32_t time = now();
+  for (uint8_t i = 0; i < _taskCount; i++)
+  {
+    Task &task = _tasks[i];
+    if ((int32_t)(time - task.nextRun) >= 0)
+    {
+      task.callback(task.context);
+      task.nextRun += task.interval;
+      if ((int32_t)(now() - task.nextRun) >= 0)
+      {
+        task.nextRun = now() + task.interval;
+      }
+    }
+  }
+  uint32_t wait = timeToNextTask();
+  _awakeMicros += micros() - start;
+
+  if (wait > 0)
+  {
+    sleepFor(wait);
+  }
+
+  if (!_pinWoke)
+  {
+    return WAKE_TIMER;
+  }
+  _pinWoke = false;
+  if (_wakeCallback)
+  {
+    start = micros();
+    _wakeCallback(_wakeContext);
+    _awakeMicros += micros() - start;
+  }
+  return WAKE_PIN;
+}
+
+uint32_t PowerScheduler::timeToNextTask()
+{
+  uint32_t time = now();
+  uint32_t wait = 0xFFFFFFFFUL;
+  for (uint8_t i = 0; i < _taskCount; i++)
+  {
+    int32_t left = (int32_t)(_tasks[i].nextRun - time);
+    if (left <= 0)
+    {
+      return 0;
+    }
+    if ((uint32_t)left < wait)
+    {
+      wait = left;
+    }
+  }
+  return wait;
+}
+
+uint16_t PowerScheduler::getDutyCycle()
+{
+  uint64_t awake = _awakeMicros / 1000;
+  uint64_t total = awake + _sleepMillis;
+  return total == 0 ? 1000 : (uint16_t)(awake * 1000 / total);
+}
+
+void PowerScheduler::resetStats()
+{
+  _awakeMicros = 0;
+  _sleepMillis = 0;
+}
+
+void PowerScheduler::printStats()
+{
+  Logger::log(INFO, "Power: awake ms ", (int32_t)getAwakeMillis());
+  Logger::log(INFO, "Power: asleep ms ", (int32_t)_sleepMillis);
+  Logger::log(INFO, "Power: duty cycle ", getDutyCycle() / 10.0f, 1, "%");
+}
+
+void PowerScheduler::sampleBattery(void *context)
+{
+  BatteryManager *manager = (BatteryManager *)context;
+  while (!manager->tick())
+  {
+  }
+}
+
+void PowerScheduler::onWakePin()
+{
+  _pinWoke = true;
+  // LOW would fire again and again while the pin is held
+  detachInterrupt(digitalPinToInterrupt(_wakePin));
+}
+
+void PowerScheduler::sleepFor(uint32_t duration)
+{
+  if (_wakePin >= 0)
+  {
+    attachInterrupt(digitalPinToInterrupt(_wakePin), onWakePin, _wakeMode);
+  }
+
+  if (_sleepHook)
+  {
+    _sleepHook(duration);
+    _virtualMillis += duration;
+    _sleepMillis += duration;
+  }
+  else
+  {
+#if defined(__AVR__)
+    // WDP3..0 = i gives 16 ms << i
+    static const uint16_t WATCHDOG_MILLIS[] = {16, 32, 64, 125, 250, 500, 1000, 2000, 4000, 8000};
+    while (duration >= WATCHDOG_MILLIS[0] && !_pinWoke)
+    {
+      uint8_t step = 9;
+      while (WATCHDOG_MILLIS[step] > duration)
+      {
+        step--;
+      }
+      watchdogFired = false;
+      noInterrupts();
+      wdt_reset();
+      MCUSR &= ~(1 << WDRF);
+      WDTCSR = (1 << WDCE) | (1 << WDE);
+      WDTCSR = (1 << WDIE) | (step & 7) | ((step & 8) ? (1 << WDP3) : 0);
+      set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+      sleep_enable();
+      interrupts();
+      sleep_cpu();
+      sleep_disable();
+      wdt_disable();
+      if (!watchdogFired)
+      {
+        // Woken by the pin after an unknown part of the step; count none of it
+        break;
+      }
+      noInterrupts();
+      advanceTimer0(WATCHDOG_MILLIS[step]);
+      interrupts();
+      _sleepMillis += WATCHDOG_MILLIS[step];
+      duration -= WATCHDOG_MILLIS[step];
+    }
+    // Timer0 wakes the idle CPU every millisecond
+    unsigned long start = millis();
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    while (!_pinWoke && millis() - start < duration)
+    {
+      sleep_mode();
+    }
+    _sleepMillis += millis() - start;
+#elif defined(ESP8266)
+    if (_deepSleepThreshold > 0 && duration >= _deepSleepThreshold)
+    {
+      // Does not return
+      ESP.deepSleep((uint64_t)duration * 1000);
+    }
+    unsigned long start = millis();
+    while (!_pinWoke && millis() - start < duration)
+    {
+      uint32_t left = duration - (millis() - start);
+      delay(left < 10 ? left : 10);
+    }
+    _sleepMillis += millis() - start;
+#else
+    delay(duration);
+    _sleepMillis += duration;
+#endif
+  }
+
+  if (_wakePin >= 0 && !_pinWoke)
+  {
+    detachInterrupt(digitalPinToInterrupt(_wakePin));
+  }
+}
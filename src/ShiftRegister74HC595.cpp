@@ -83,27 +83,46 @@ void ShiftRegister74HC595::setAll()
   updateRegisters();
 }
 
-// Update the shift registers (push the changes to the actual hardware)
-void ShiftRegister74HC595::updateRegisters()
+// Set the bits selected by mask on one register without latching them out
+void ShiftRegister74HC595::setBits(uint8_t registerIndex, uint8_t mask, uint8_t bits)
 {
-  Logger::info("Updating shift registers...");
+  if (registerIndex >= _numRegisters)
+  {
+    return;
+  }
+  _registerState[registerIndex] = (_registerState[registerIndex] & ~mask) | (bits & mask);
+}
+
+// Get the buffered state of one register
+uint8_t ShiftRegister74HC595::getRegister(uint8_t registerIndex) const
+{
+  if (registerIndex >= _numRegisters)
+  {
+    return 0;
+  }
+  return _registerState[registerIndex];
+}
 
+// Update the shift registers (push the changes to the actual hardware).
+// No logging here: this runs once per address latch in the SRAM burst path.
+void ShiftRegister74HC595::updateRegisters()
+{
   digitalWrite(_latchPin, LOW); // Begin the update by setting the latch low
-  Logger::trace("Latch pin " + String(_latchPin) + " set to LOW.");
 
   // Send out the bytes for each shift register, starting with the last one
   for (int i = _numRegisters - 1; i >= 0; i--)
   {
-    uint8_t shiftedByte = _registerState[i];
-    Logger::trace("Shifting out byte: 0x" + String(shiftedByte, HEX) + " for register " + String(i));
-    shiftOut(_dataPin, _clockPin, MSBFIRST, shiftedByte);
-    Logger::trace("Data shifted out to register " + String(i));
+    shiftOut(_dataPin, _clockPin, MSBFIRST, _registerState[i]);
   }
 
   digitalWrite(_latchPin, HIGH); // Complete the update by setting the latch high
-  Logger::trace("Latch pin " + String(_latchPin) + " set to HIGH.");
 
   // Small delay to ensure registers have time to settle
   delayMicroseconds(5);
-  Logger::trace("Registers updated and latched.");
+}
+
+// Whether both objects drive the same latch, clock and data pins (one daisy chain)
+bool ShiftRegister74HC595::sharesPinsWith(const ShiftRegister74HC595 *other) const
+{
+  return other && other->_latchPin == _latchPin && other->_clockPin == _clockPin && other->_dataPin == _dataPin;
 }
@@ -0,0 +1,222 @@
+#include "SramBank.h"
+#include "logger.h"
+
+/**
+ * Constructor for chips selected by one GPIO /CE pin each.
+ *
+ * @param sram The HY62252A driving the shared buses.
+ * @param cePins Array of chipCount /CE pins, chip 0 first.
+ * @param chipCount Number of chips (1-4).
+ */
+SramBank::SramBank(HY62252A *sram, const uint8_t *cePins, uint8_t chipCount)
+    : _sram(sram), _selectRegister(nullptr), _firstSelectPin(0), _chipCount(chipCount), _currentChip(0xFF), _bankSwitches(0)
+{
+  if (_chipCount > MAX_CHIPS)
+  {
+    Logger::warning("SramBank: only " + String(MAX_CHIPS) + " chips supported");
+    _chipCount = MAX_CHIPS;
+  }
+  for (uint8_t i = 0; i < _chipCount; i++)
+  {
+    _cePins[i] = cePins[i];
+  }
+}
+
+/**
+ * Constructor for chips selected by extra address bits on shift register
+ * outputs. The select bits (1 for two chips, 2 for three or four) must sit
+ * in the same 8-bit register, starting at firstSelectPin.
+ *
+ * @param sram The HY62252A driving the shared buses.
+ * @param selectRegister Shift register carrying the select bits.
+ * @param firstSelectPin Output pin of the lowest select bit.
+ * @param chipCount Number of chips (1-4).
+ */
+SramBank::SramBank(HY62252A *sram, ShiftRegister74HC595 *selectRegister, uint8_t firstSelectPin, uint8_t chipCount)
+    : _sram(sram), _selectRegister(selectRegister), _firstSelectPin(firstSelectPin), _chipCount(chipCount), _currentChip(0xFF), _bankSwitches(0)
+{
+  if (_chipCount > MAX_CHIPS)
+  {
+    Logger::warning("SramBank: only " + String(MAX_CHIPS) + " chips supported");
+    _chipCount = MAX_CHIPS;
+  }
+}
+
+/**
+ * Initializes the select lines and selects chip 0.
+ */
+void SramBank::begin()
+{
+  if (!_selectRegister)
+  {
+    for (uint8_t i = 0; i < _chipCount; i++)
+    {
+      pinMode(_cePins[i], OUTPUT);
+      digitalWrite(_cePins[i], HIGH); // Disable chip
+    }
+  }
+  if (_sram->sharesAddressChain(_selectRegister))
+  {
+    Logger::error("SramBank: the select register must be an address register or have its own pins");
+  }
+  _currentChip = 0xFF;
+  selectChip(0);
+  Logger::info("SramBank initialized with " + String(_chipCount) + " chips");
+}
+
+/**
+ * Writes a byte at a flat address.
+ *
+ * @param address The flat address.
+ * @param data The byte to write.
+ */
+void SramBank::writeByte(uint32_t address, uint8_t data)
+{
+  if (address >= size())
+  {
+    Logger::error("SramBank: write outside address space: " + String(address));
+    return;
+  }
+  selectChip(address >> 15);
+  _sram->writeByte(address & (CHIP_SIZE - 1), data);
+}
+
+/**
+ * Reads a byte from a flat address.
+ *
+ * @param address The flat address.
+ * @return The byte read, 0 if the address is out of range.
+ */
+uint8_t SramBank::readByte(uint32_t address)
+{
+  if (address >= size())
+  {
+    Logger::error("SramBank: read outside address space: " + String(address));
+    return 0;
+  }
+  selectChip(address >> 15);
+  return _sram->readByte(address & (CHIP_SIZE - 1));
+}
+
+/**
+ * Writes a block, split into one burst per chip it touches.
+ *
+ * @param startAddress The flat start address.
+ * @param data The data to write.
+ * @param length Number of bytes to write.
+ */
+void SramBank::writeBlock(uint32_t startAddress, const uint8_t *data, uint32_t length)
+{
+  if (!clip(startAddress, length))
+  {
+    return;
+  }
+  while (length > 0)
+  {
+    uint16_t offset = startAddress & (CHIP_SIZE - 1);
+    uint32_t chunk = CHIP_SIZE - offset;
+    if (chunk > length)
+    {
+      chunk = length;
+    }
+    selectChip(startAddress >> 15);
+    _sram->writeBlock(offset, data, (uint16_t)chunk);
+    startAddress += chunk;
+    data += chunk;
+    length -= chunk;
+  }
+}
+
+/**
+ * Reads a block, split into one burst per chip it touches.
+ *
+ * @param startAddress The flat start address.
+ * @param buffer Buffer to store the data.
+ * @param length Number of bytes to read.
+ */
+void SramBank::readBlock(uint32_t startAddress, uint8_t *buffer, uint32_t length)
+{
+  if (!clip(startAddress, length))
+  {
+    return;
+  }
+  while (length > 0)
+  {
+    uint16_t offset = startAddress & (CHIP_SIZE - 1);
+    uint32_t chunk = CHIP_SIZE - offset;
+    if (chunk > length)
+    {
+      chunk = length;
+    }
+    selectChip(startAddress >> 15);
+    _sram->readBlock(offset, buffer, (uint16_t)chunk);
+    startAddress += chunk;
+    buffer += chunk;
+    length -= chunk;
+  }
+}
+
+/**
+ * Selects a chip. Does nothing if it is already selected, so runs of
+ * accesses to the same chip pay for the switch only once.
+ *
+ * Select bits on an address register (e.g. Q7 of the upper one) are only
+ * buffered here: shifting that register alone would push one byte into a
+ * daisy chain and move the stale one along. Instead the SRAM forgets its
+ * latched address, so the next access latches the whole chain with the
+ * new select bits, even at the same in-chip offset.
+ *
+ * @param chip Chip index.
+ */
+void SramBank::selectChip(uint8_t chip)
+{
+  if (chip == _currentChip)
+  {
+    return;
+  }
+
+  if (_selectRegister)
+  {
+    uint8_t registerIndex = _firstSelectPin / 8;
+    uint8_t shift = _firstSelectPin % 8;
+    uint8_t mask = (_chipCount > 2 ? 0x03 : 0x01) << shift;
+    _selectRegister->setBits(registerIndex, mask, chip << shift);
+    if (_sram->isAddressRegister(_selectRegister))
+    {
+      _sram->invalidateAddress();
+    }
+    else
+    {
+      _selectRegister->updateRegisters();
+    }
+  }
+  else
+  {
+    _sram->setChipEnablePin(_cePins[chip]);
+  }
+
+  _currentChip = chip;
+  _bankSwitches++;
+}
+
+/**
+ * Clips a transfer so it stays inside the address space.
+ *
+ * @param startAddress The flat start address.
+ * @param length Transfer length, shortened if it runs past the end.
+ * @return false if nothing is left to transfer.
+ */
+bool SramBank::clip(uint32_t startAddress, uint32_t &length)
+{
+  if (startAddress >= size())
+  {
+    Logger::error("SramBank: transfer outside address space: " + String(startAddress));
+    return false;
+  }
+  if (length > size() - startAddress)
+  {
+    Logger::warning("SramBank: transfer clipped at end of address space");
+    length = size() - startAddress;
+  }
+  return length > 0;
+}
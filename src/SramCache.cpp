@@ -0,0 +1,227 @@
+#include "SramCache.h"
+#include "logger.h"
+
+/**
+ * Constructor for the write-back cache.
+ *
+ * @param sram The SRAM chip behind the cache.
+ * @param numLines Number of cache lines kept in MCU RAM.
+ * @param lineSize Bytes per line, must be a power of two.
+ */
+SramCache::SramCache(HY62252A *sram, uint8_t numLines, uint8_t lineSize)
+    : _sram(sram), _numLines(numLines), _lineSize(lineSize), _clock(0), _hits(0), _misses(0), _writebacks(0)
+{
+  if (_numLines == 0)
+  {
+    _numLines = 1;
+  }
+  if (_lineSize == 0 || (_lineSize & (_lineSize - 1)) != 0)
+  {
+    Logger::warning("SramCache: line size " + String(lineSize) + " is not a power of two, using 16");
+    _lineSize = 16;
+  }
+  _tagMask = ~(uint16_t)(_lineSize - 1);
+
+  _lines = new Line[_numLines];
+  _data = new uint8_t[(uint16_t)_numLines * _lineSize];
+  for (uint8_t i = 0; i < _numLines; i++)
+  {
+    _lines[i].tag = 0;
+    _lines[i].lastUse = 0;
+    _lines[i].valid = false;
+    _lines[i].dirty = false;
+  }
+}
+
+SramCache::~SramCache()
+{
+  flush();
+  delete[] _lines;
+  delete[] _data;
+}
+
+/**
+ * Reads a byte through the cache.
+ *
+ * @param address The SRAM address to read.
+ * @return The byte at the address.
+ */
+uint8_t SramCache::readByte(uint16_t address)
+{
+  uint8_t index = lookup(address);
+  return _data[(uint16_t)index * _lineSize + (address & (_lineSize - 1))];
+}
+
+/**
+ * Writes a byte into the cache and marks its line dirty.
+ *
+ * @param address The SRAM address to write.
+ * @param data The byte to write.
+ */
+void SramCache::writeByte(uint16_t address, uint8_t data)
+{
+  uint8_t index = lookup(address);
+  _data[(uint16_t)index * _lineSize + (address & (_lineSize - 1))] = data;
+  _lines[index].dirty = true;
+}
+
+/**
+ * Reads a block through the cache, one line segment at a time.
+ *
+ * @param startAddress The start address.
+ * @param buffer Buffer to store the data.
+ * @param length Number of bytes to read.
+ */
+void SramCache::readBlock(uint16_t startAddress, uint8_t *buffer, uint16_t length)
+{
+  while (length > 0)
+  {
+    uint8_t offset = startAddress & (_lineSize - 1);
+    uint16_t chunk = _lineSize - offset;
+    if (chunk > length)
+    {
+      chunk = length;
+    }
+    uint8_t index = lookup(startAddress);
+    memcpy(buffer, &_data[(uint16_t)index * _lineSize + offset], chunk);
+    startAddress += chunk;
+    buffer += chunk;
+    length -= chunk;
+  }
+}
+
+/**
+ * Writes a block through the cache, one line segment at a time.
+ * Segments that cover a whole line are allocated without filling it first.
+ *
+ * @param startAddress The start address.
+ * @param data The data to write.
+ * @param length Number of bytes to write.
+ */
+void SramCache::writeBlock(uint16_t startAddress, const uint8_t *data, uint16_t length)
+{
+  while (length > 0)
+  {
+    uint8_t offset = startAddress & (_lineSize - 1);
+    uint16_t chunk = _lineSize - offset;
+    if (chunk > length)
+    {
+      chunk = length;
+    }
+    uint8_t index = lookup(startAddress, chunk != _lineSize);
+    memcpy(&_data[(uint16_t)index * _lineSize + offset], data, chunk);
+    _lines[index].dirty = true;
+    startAddress += chunk;
+    data += chunk;
+    length -= chunk;
+  }
+}
+
+/**
+ * Writes every dirty line back to the SRAM.
+ */
+void SramCache::flush()
+{
+  for (uint8_t i = 0; i < _numLines; i++)
+  {
+    flushLine(i);
+  }
+}
+
+/**
+ * Flushes and then drops every line.
+ */
+void SramCache::invalidate()
+{
+  flush();
+  for (uint8_t i = 0; i < _numLines; i++)
+  {
+    _lines[i].valid = false;
+  }
+}
+
+/**
+ * Resets the hit/miss statistics.
+ */
+void SramCache::resetStats()
+{
+  _hits = 0;
+  _misses = 0;
+  _writebacks = 0;
+}
+
+/**
+ * Finds the line holding the address. On a miss the least recently used
+ * line is written back (if dirty) and refilled with a burst read.
+ *
+ * @param address The SRAM address.
+ * @param fill Whether a missed line must be read from the SRAM.
+ * @return Index of the line holding the address.
+ */
+uint8_t SramCache::lookup(uint16_t address, bool fill)
+{
+  uint16_t tag = address & _tagMask;
+  uint8_t victim = 0;
+
+  for (uint8_t i = 0; i < _numLines; i++)
+  {
+    if (_lines[i].valid && _lines[i].tag == tag)
+    {
+      _hits++;
+      _lines[i].lastUse = nextStamp();
+      return i;
+    }
+    // Prefer an empty line, otherwise the oldest one
+    if (_lines[victim].valid && (!_lines[i].valid || _lines[i].lastUse < _lines[victim].lastUse))
+    {
+      victim = i;
+    }
+  }
+
+  _misses++;
+  flushLine(victim);
+  if (fill)
+  {
+    _sram->readBlock(tag, &_data[(uint16_t)victim * _lineSize], _lineSize);
+  }
+  _lines[victim].tag = tag;
+  _lines[victim].valid = true;
+  _lines[victim].dirty = false;
+  _lines[victim].lastUse = nextStamp();
+  return victim;
+}
+
+/**
+ * Writes a line back to the SRAM with a burst write if it is dirty.
+ *
+ * @param index The line index.
+ */
+void SramCache::flushLine(uint8_t index)
+{
+  Line &line = _lines[index];
+  if (line.valid && line.dirty)
+  {
+    _sram->writeBlock(line.tag, &_data[(uint16_t)index * _lineSize], _lineSize);
+    line.dirty = false;
+    _writebacks++;
+  }
+}
+
+/**
+ * Advances the LRU clock. When it wraps, all stamps are collapsed so the
+ * relative order of the lines is lost but no line looks newer than it is.
+ *
+ * @return The new stamp.
+ */
+uint16_t SramCache::nextStamp()
+{
+  if (++_clock == 0)
+  {
+    for (uint8_t i = 0; i < _numLines; i++)
+    {
+      _lines[i].lastUse = 0;
+    }
+    _clock = 1;
+  }
+  return _clock;
+}
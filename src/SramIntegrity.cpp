@@ -0,0 +1,329 @@
+#include "SramIntegrity.h"
+#include "Crc.h"
+#include "logger.h"
+
+// Bytes read per burst when streaming a block through the CRC
+static const uint8_t SCRUB_CHUNK = 16;
+
+/**
+ * Constructor for the integrity layer.
+ *
+ * @param sram The SRAM chip.
+ * @param baseAddress Start of the protected region.
+ * @param blockSize Bytes per block.
+ * @param blockCount Number of blocks in the region.
+ * @param width CRC8 (1 byte per block) or CRC16 (2 bytes per block).
+ */
+SramIntegrity::SramIntegrity(HY62252A *sram, uint16_t baseAddress, uint16_t blockSize, uint16_t blockCount, CrcWidth width)
+    : _sram(sram), _base(baseAddress), _blockSize(blockSize), _blockCount(blockCount), _width(width), _corruptCount(0),
+      _scrubBlock(0), _scrubOffset(0), _scrubCrc(0), _scrubPasses(0), _callback(nullptr), _callbackContext(nullptr)
+{
+  if (_blockSize == 0)
+  {
+    _blockSize = 1;
+  }
+  _crcs = new uint8_t[(uint16_t)_blockCount * _width];
+  _corrupt = new uint8_t[(_blockCount + 7) / 8];
+  memset(_corrupt, 0, (_blockCount + 7) / 8);
+  _scrubCrc = crcInit();
+}
+
+SramIntegrity::~SramIntegrity()
+{
+  delete[] _crcs;
+  delete[] _corrupt;
+}
+
+/**
+ * Seals the region: computes every block's CRC from the current contents
+ * and clears all corruption flags.
+ */
+void SramIntegrity::begin()
+{
+  for (uint16_t i = 0; i < _blockCount; i++)
+  {
+    storeCrc(i, computeBlockCrc(i));
+  }
+  memset(_corrupt, 0, (_blockCount + 7) / 8);
+  _corruptCount = 0;
+  _scrubBlock = 0;
+  _scrubOffset = 0;
+  _scrubCrc = crcInit();
+  Logger::info("SramIntegrity sealed " + String(_blockCount) + " blocks of " + String(_blockSize) + " bytes");
+}
+
+/**
+ * Writes data to the SRAM and updates the CRCs of the touched blocks.
+ *
+ * Blocks that are completely overwritten get their CRC straight from the
+ * new data, which also clears their corruption flag. For partially written
+ * blocks the old contents are streamed once to both check the old CRC and
+ * build the new one, so corruption in the untouched part of the block is
+ * reported instead of silently resealed. A flagged block stays flagged after
+ * a partial write, since its new CRC covers the corrupt bytes.
+ *
+ * @param startAddress The start address.
+ * @param data The data to write.
+ * @param length Number of bytes.
+ */
+void SramIntegrity::writeBlock(uint16_t startAddress, const uint8_t *data, uint16_t length)
+{
+  uint16_t regionEnd = _base + _blockSize * _blockCount;
+  uint16_t end = startAddress + length;
+
+  if (startAddress < regionEnd && end > _base)
+  {
+    uint16_t first = (startAddress < _base ? 0 : (startAddress - _base) / _blockSize);
+    uint16_t last = ((end > regionEnd ? regionEnd : end) - 1 - _base) / _blockSize;
+
+    for (uint16_t block = first; block <= last; block++)
+    {
+      uint16_t blockStart = _base + block * _blockSize;
+      uint16_t crc = crcInit();
+
+      if (startAddress <= blockStart && end >= blockStart + _blockSize)
+      {
+        crc = crcUpdate(crc, data + (blockStart - startAddress), _blockSize);
+        markCorrupt(block, false);
+      }
+      else
+      {
+        uint16_t oldCrc = crcInit();
+        uint8_t chunk[SCRUB_CHUNK];
+        for (uint16_t offset = 0; offset < _blockSize; offset += SCRUB_CHUNK)
+        {
+          uint16_t n = _blockSize - offset < SCRUB_CHUNK ? _blockSize - offset : SCRUB_CHUNK;
+          uint16_t address = blockStart + offset;
+          _sram->readBlock(address, chunk, n);
+          oldCrc = crcUpdate(oldCrc, chunk, n);
+          for (uint16_t i = 0; i < n; i++)
+          {
+            uint16_t a = address + i;
+            if (a >= startAddress && a < end)
+            {
+              chunk[i] = data[a - startAddress];
+            }
+          }
+          crc = crcUpdate(crc, chunk, n);
+        }
+        if (oldCrc != storedCrc(block) && !isBlockCorrupt(block))
+        {
+          Logger::warning("SramIntegrity: block " + String(block) + " was corrupt before write");
+          markCorrupt(block, true);
+          if (_callback)
+          {
+            _callback(block, blockStart, _callbackContext);
+          }
+        }
+      }
+
+      storeCrc(block, crc);
+      if (block == _scrubBlock)
+      {
+        // The running scrub CRC is stale now, restart this block
+        _scrubOffset = 0;
+        _scrubCrc = crcInit();
+      }
+    }
+  }
+
+  _sram->writeBlock(startAddress, data, length);
+}
+
+/**
+ * Reads data from the SRAM.
+ *
+ * @param startAddress The start address.
+ * @param buffer Buffer to store the data.
+ * @param length Number of bytes.
+ */
+void SramIntegrity::readBlock(uint16_t startAddress, uint8_t *buffer, uint16_t length)
+{
+  _sram->readBlock(startAddress, buffer, length);
+}
+
+/**
+ * Verifies one block against its stored CRC and flags it on a mismatch.
+ *
+ * A matching CRC does not clear an existing flag: after a partial write to a
+ * flagged block the CRC covers the corrupt bytes too, so only a full rewrite,
+ * resealBlock() or begin() clears it.
+ *
+ * @param blockIndex The block.
+ * @return true if the block matches its CRC and is not flagged.
+ */
+bool SramIntegrity::verifyBlock(uint16_t blockIndex)
+{
+  if (blockIndex >= _blockCount)
+  {
+    return false;
+  }
+  if (computeBlockCrc(blockIndex) != storedCrc(blockIndex))
+  {
+    markCorrupt(blockIndex, true);
+    return false;
+  }
+  return !isBlockCorrupt(blockIndex);
+}
+
+/**
+ * Background scrubber step. Streams at most maxBytes of the region through
+ * the CRC, carrying the running CRC of a partially checked block over to the
+ * next call. Each block whose CRC does not match is flagged and reported.
+ * The scrubber never clears a flag (see verifyBlock()).
+ *
+ * @param maxBytes Upper bound on the bytes read by this call.
+ * @return Number of newly found corrupted blocks.
+ */
+uint16_t SramIntegrity::scrubStep(uint16_t maxBytes)
+{
+  uint16_t found = 0;
+  uint8_t chunk[SCRUB_CHUNK];
+
+  while (maxBytes > 0 && _blockCount > 0)
+  {
+    uint16_t n = _blockSize - _scrubOffset;
+    if (n > SCRUB_CHUNK)
+    {
+      n = SCRUB_CHUNK;
+    }
+    if (n > maxBytes)
+    {
+      n = maxBytes;
+    }
+    uint16_t blockStart = _base + _scrubBlock * _blockSize;
+    _sram->readBlock(blockStart + _scrubOffset, chunk, n);
+    _scrubCrc = crcUpdate(_scrubCrc, chunk, n);
+    _scrubOffset += n;
+    maxBytes -= n;
+
+    if (_scrubOffset >= _blockSize)
+    {
+      bool ok = _scrubCrc == storedCrc(_scrubBlock);
+      if (!ok && !isBlockCorrupt(_scrubBlock))
+      {
+        found++;
+        Logger::warning("SramIntegrity: corrupted block " + String(_scrubBlock) + " at address " + String(blockStart));
+        markCorrupt(_scrubBlock, true);
+        if (_callback)
+        {
+          _callback(_scrubBlock, blockStart, _callbackContext);
+        }
+      }
+
+      _scrubOffset = 0;
+      _scrubCrc = crcInit();
+      if (++_scrubBlock >= _blockCount)
+      {
+        _scrubBlock = 0;
+        _scrubPasses++;
+      }
+    }
+  }
+  return found;
+}
+
+/**
+ * Registers the callback for corrupted blocks.
+ *
+ * @param callback Function to call, nullptr to remove.
+ * @param context Passed to the callback.
+ */
+void SramIntegrity::onCorruption(SramCorruptionCallback callback, void *context)
+{
+  _callback = callback;
+  _callbackContext = context;
+}
+
+bool SramIntegrity::isBlockCorrupt(uint16_t blockIndex) const
+{
+  if (blockIndex >= _blockCount)
+  {
+    return false;
+  }
+  return (_corrupt[blockIndex / 8] >> (blockIndex % 8)) & 1;
+}
+
+/**
+ * Accepts the current SRAM contents of a block as correct.
+ *
+ * @param blockIndex The block.
+ */
+void SramIntegrity::resealBlock(uint16_t blockIndex)
+{
+  if (blockIndex >= _blockCount)
+  {
+    return;
+  }
+  storeCrc(blockIndex, computeBlockCrc(blockIndex));
+  markCorrupt(blockIndex, false);
+  if (blockIndex == _scrubBlock)
+  {
+    _scrubOffset = 0;
+    _scrubCrc = crcInit();
+  }
+}
+
+uint16_t SramIntegrity::computeBlockCrc(uint16_t blockIndex)
+{
+  uint8_t chunk[SCRUB_CHUNK];
+  uint16_t crc = crcInit();
+  uint16_t blockStart = _base + blockIndex * _blockSize;
+  for (uint16_t offset = 0; offset < _blockSize; offset += SCRUB_CHUNK)
+  {
+    uint16_t n = _blockSize - offset < SCRUB_CHUNK ? _blockSize - offset : SCRUB_CHUNK;
+    _sram->readBlock(blockStart + offset, chunk, n);
+    crc = crcUpdate(crc, chunk, n);
+  }
+  return crc;
+}
+
+uint16_t SramIntegrity::storedCrc(uint16_t blockIndex) const
+{
+  if (_width == CRC8)
+  {
+    return _crcs[blockIndex];
+  }
+  return _crcs[blockIndex * 2] | ((uint16_t)_crcs[blockIndex * 2 + 1] << 8);
+}
+
+void SramIntegrity::storeCrc(uint16_t blockIndex, uint16_t crc)
+{
+  if (_width == CRC8)
+  {
+    _crcs[blockIndex] = (uint8_t)crc;
+    return;
+  }
+  _crcs[blockIndex * 2] = crc & 0xFF;
+  _crcs[blockIndex * 2 + 1] = crc >> 8;
+}
+
+uint16_t SramIntegrity::crcInit() const
+{
+  return _width == CRC8 ? Crc::CRC8_INIT : Crc::CRC16_INIT;
+}
+
+uint16_t SramIntegrity::crcUpdate(uint16_t crc, const uint8_t *data, uint16_t length) const
+{
+  if (_width == CRC8)
+  {
+    return Crc::crc8(data, length, (uint8_t)crc);
+  }
+  return Crc::crc16(data, length, crc);
+}
+
+void SramIntegrity::markCorrupt(uint16_t blockIndex, bool corrupt)
+{
+  uint8_t bit = 1 << (blockIndex % 8);
+  bool was = _corrupt[blockIndex / 8] & bit;
+  if (corrupt && !was)
+  {
+    _corrupt[blockIndex / 8] |= bit;
+    _corruptCount++;
+  }
+  else if (!corrupt && was)
+  {
+    _corrupt[blockIndex / 8] &= ~bit;
+    _corruptCount--;
+  }
+}
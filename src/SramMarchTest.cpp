@@ -0,0 +1,278 @@
+#include "SramMarchTest.h"
+#include "logger.h"
+
+SramMarchTest::SramMarchTest(SramDevice *sram)
+    : _sram(sram)
+{
+  memset(&_report, 0, sizeof(_report));
+}
+
+/**
+ * Runs the selected tests. The data line test runs first when selected, so
+ * the address line test can ignore lines already known to be stuck.
+ *
+ * @param tests Bitmask of Test values.
+ * @return The report.
+ */
+const SramTestReport &SramMarchTest::run(uint8_t tests)
+{
+  memset(&_report, 0, sizeof(_report));
+  _report.passed = true;
+  unsigned long start = micros();
+
+  if (tests & DATA_LINES)
+  {
+    Logger::info("SRAM test: data lines");
+    _report.passed &= testDataLines();
+  }
+  if (tests & ADDRESS_LINES)
+  {
+    Logger::info("SRAM test: address lines");
+    _report.passed &= testAddressLines();
+  }
+  if (tests & WALKING_ONES)
+  {
+    Logger::info("SRAM test: walking ones");
+    _report.passed &= testWalkingOnes();
+  }
+  if (tests & MARCH_C_MINUS)
+  {
+    Logger::info("SRAM test: March C-");
+    _report.passed &= testMarchCMinus();
+  }
+
+  _report.elapsedMicros = micros() - start;
+  if (_report.elapsedMicros > 0)
+  {
+    _report.bytesPerSecond = (uint32_t)((uint64_t)_report.bytesMoved * 1000000UL / _report.elapsedMicros);
+  }
+  return _report;
+}
+
+/**
+ * Walks a single one and a single zero across the data bus at address 0.
+ * A line that reads 0 while driven 1 is stuck low, and the other way round.
+ *
+ * @return true if no data line is stuck.
+ */
+bool SramMarchTest::testDataLines()
+{
+  bool ok = true;
+  for (uint8_t bit = 0; bit < 8; bit++)
+  {
+    uint8_t one = 1 << bit;
+    _sram->writeByte(0, one);
+    uint8_t actual = _sram->readByte(0);
+    if (actual != one)
+    {
+      recordFailure(0, one, actual);
+      ok = false;
+    }
+    if (!(actual & one))
+    {
+      _report.dataLinesStuckLow |= one;
+    }
+
+    uint8_t zero = ~one;
+    _sram->writeByte(0, zero);
+    actual = _sram->readByte(0);
+    if (actual != zero)
+    {
+      recordFailure(0, zero, actual);
+      ok = false;
+    }
+    if (actual & one)
+    {
+      _report.dataLinesStuckHigh |= one;
+    }
+  }
+  _report.bytesMoved += 32;
+  return ok;
+}
+
+/**
+ * Checks that address 0 and every power-of-two address are distinct cells.
+ * A power-of-two cell that changes when address 0 is written means that
+ * line is stuck low; address 0 changing when a power-of-two cell is written
+ * means stuck high; another power-of-two cell changing means shorted lines.
+ *
+ * @return true if no address line fault was found.
+ */
+bool SramMarchTest::testAddressLines()
+{
+  const uint8_t pattern = 0x55;
+  const uint8_t antipattern = 0xAA;
+  uint8_t lines = 0;
+  while ((1UL << lines) < _sram->size())
+  {
+    lines++;
+  }
+
+  bool ok = true;
+  for (uint8_t k = 0; k < lines; k++)
+  {
+    _sram->writeByte(1 << k, pattern);
+  }
+  _sram->writeByte(0, antipattern);
+  for (uint8_t k = 0; k < lines; k++)
+  {
+    if (!checkByte(1 << k, pattern))
+    {
+      _report.addressLineErrors |= (1 << k);
+      ok = false;
+    }
+  }
+
+  _sram->writeByte(0, pattern);
+  for (uint8_t k = 0; k < lines; k++)
+  {
+    _sram->writeByte(1 << k, antipattern);
+    if (!checkByte(0, pattern))
+    {
+      _report.addressLineErrors |= (1 << k);
+      ok = false;
+    }
+    for (uint8_t j = 0; j < lines; j++)
+    {
+      if (j != k && !checkByte(1 << j, pattern))
+      {
+        _report.addressLineErrors |= (1 << k) | (1 << j);
+        ok = false;
+      }
+    }
+    _sram->writeByte(1 << k, pattern);
+  }
+  _report.bytesMoved += (uint32_t)lines * (lines + 4) + 2;
+  return ok;
+}
+
+/**
+ * Fills the whole chip with each single-bit pattern in turn and verifies it.
+ *
+ * @return true if every cell held every pattern.
+ */
+bool SramMarchTest::testWalkingOnes()
+{
+  bool ok = true;
+  for (uint8_t bit = 0; bit < 8; bit++)
+  {
+    fill(1 << bit);
+    ok &= verify(1 << bit);
+  }
+  return ok;
+}
+
+/**
+ * March C- with 0x00/0xFF data backgrounds.
+ *
+ * @return true if no cell failed.
+ */
+bool SramMarchTest::testMarchCMinus()
+{
+  bool ok = true;
+  fill(0x00);
+  ok &= marchElement(true, 0x00, 0xFF);
+  ok &= marchElement(true, 0xFF, 0x00);
+  ok &= marchElement(false, 0x00, 0xFF);
+  ok &= marchElement(false, 0xFF, 0x00);
+  ok &= verify(0x00);
+  return ok;
+}
+
+/**
+ * Logs the report.
+ */
+void SramMarchTest::printReport() const
+{
+  Logger::info(String("SRAM test ") + (_report.passed ? "PASSED" : "FAILED") + ", failures: " + String(_report.failures));
+  Logger::info("Throughput: " + String(_report.bytesPerSecond) + " bytes/s (" + String(_report.bytesMoved) +
+               " bytes in " + String(_report.elapsedMicros) + " us)");
+  if (!_report.passed)
+  {
+    Logger::info("Data lines stuck high: 0x" + String(_report.dataLinesStuckHigh, HEX) +
+                 ", stuck low: 0x" + String(_report.dataLinesStuckLow, HEX) +
+                 ", failing: 0x" + String(_report.dataLineErrors, HEX));
+    Logger::info("Address lines failing: 0x" + String(_report.addressLineErrors, HEX));
+    for (uint8_t i = 0; i < _report.firstFailureCount; i++)
+    {
+      Logger::info("Failure at address 0x" + String(_report.firstFailures[i], HEX));
+    }
+  }
+}
+
+void SramMarchTest::fill(uint8_t pattern)
+{
+  uint8_t chunk[CHUNK];
+  memset(chunk, pattern, CHUNK);
+  for (uint32_t address = 0; address < _sram->size(); address += CHUNK)
+  {
+    _sram->writeBlock(address, chunk, CHUNK);
+  }
+  _report.bytesMoved += _sram->size();
+}
+
+bool SramMarchTest::verify(uint8_t expected)
+{
+  return marchElement(true, expected, expected);
+}
+
+/**
+ * Runs one march element over the whole chip. When pattern equals expected
+ * the element is read-only.
+ *
+ * @param ascending Address order.
+ * @param expected Value every cell must read back.
+ * @param pattern Value written to every cell after it was read.
+ * @return true if every cell read back expected.
+ */
+bool SramMarchTest::marchElement(bool ascending, uint8_t expected, uint8_t pattern)
+{
+  bool ok = true;
+  bool writeBack = pattern != expected;
+  uint8_t chunk[CHUNK];
+  uint8_t fresh[CHUNK];
+  memset(fresh, pattern, CHUNK);
+  uint16_t chunks = _sram->size() / CHUNK;
+
+  for (uint16_t i = 0; i < chunks; i++)
+  {
+    uint16_t address = (ascending ? i : chunks - 1 - i) * CHUNK;
+    _sram->readBlock(address, chunk, CHUNK);
+    for (uint8_t j = 0; j < CHUNK; j++)
+    {
+      if (chunk[j] != expected)
+      {
+        recordFailure(address + j, expected, chunk[j]);
+        ok = false;
+      }
+    }
+    if (writeBack)
+    {
+      _sram->writeBlock(address, fresh, CHUNK);
+    }
+  }
+  _report.bytesMoved += (uint32_t)_sram->size() * (writeBack ? 2 : 1);
+  return ok;
+}
+
+bool SramMarchTest::checkByte(uint16_t address, uint8_t expected)
+{
+  uint8_t mask = ~(_report.dataLinesStuckHigh | _report.dataLinesStuckLow);
+  uint8_t actual = _sram->readByte(address);
+  if ((actual & mask) != (expected & mask))
+  {
+    recordFailure(address, expected, actual);
+    return false;
+  }
+  return true;
+}
+
+void SramMarchTest::recordFailure(uint16_t address, uint8_t expected, uint8_t actual)
+{
+  _report.failures++;
+  _report.dataLineErrors |= expected ^ actual;
+  if (_report.firstFailureCount < 4)
+  {
+    _report.firstFailures[_report.firstFailureCount++] = address;
+  }
+}
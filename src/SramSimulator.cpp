@@ -0,0 +1,122 @@
+#include "SramSimulator.h"
+
+/**
+ * Constructor for the simulated SRAM.
+ *
+ * @param storage Caller-provided backing buffer of size bytes.
+ * @param size Simulated chip size, a power of two.
+ */
+SramSimulator::SramSimulator(uint8_t *storage, uint16_t size)
+    : _storage(storage), _size(size)
+{
+  clearFaults();
+}
+
+void SramSimulator::writeByte(uint16_t address, uint8_t data)
+{
+  _storage[mapAddress(address)] = mapData(data);
+}
+
+uint8_t SramSimulator::readByte(uint16_t address)
+{
+  uint16_t physical = mapAddress(address);
+  for (uint8_t i = 0; i < _stuckCellCount; i++)
+  {
+    if (_stuckCellAddress[i] == physical)
+    {
+      return mapData(_stuckCellValue[i]);
+    }
+  }
+  return mapData(_storage[physical]);
+}
+
+void SramSimulator::writeBlock(uint16_t startAddress, const uint8_t *data, uint16_t length)
+{
+  for (uint16_t i = 0; i < length; i++)
+  {
+    writeByte(startAddress + i, data[i]);
+  }
+}
+
+void SramSimulator::readBlock(uint16_t startAddress, uint8_t *buffer, uint16_t length)
+{
+  for (uint16_t i = 0; i < length; i++)
+  {
+    buffer[i] = readByte(startAddress + i);
+  }
+}
+
+/**
+ * Forces a data line to a fixed level, for reads and writes alike.
+ *
+ * @param line Data line 0-7.
+ * @param level The level the line is stuck at.
+ */
+void SramSimulator::injectDataLineStuck(uint8_t line, bool level)
+{
+  if (level)
+  {
+    _dataStuckHigh |= (1 << line);
+  }
+  else
+  {
+    _dataStuckLow |= (1 << line);
+  }
+}
+
+/**
+ * Forces an address line to a fixed level, so two addresses alias.
+ *
+ * @param line Address line.
+ * @param level The level the line is stuck at.
+ */
+void SramSimulator::injectAddressLineStuck(uint8_t line, bool level)
+{
+  if (level)
+  {
+    _addressStuckHigh |= (1 << line);
+  }
+  else
+  {
+    _addressStuckLow |= (1 << line);
+  }
+}
+
+/**
+ * Makes one cell ignore writes and always read back value.
+ *
+ * @param address The cell.
+ * @param value The value it reads back.
+ * @return false if all stuck cell slots are in use.
+ */
+bool SramSimulator::injectStuckCell(uint16_t address, uint8_t value)
+{
+  if (_stuckCellCount >= MAX_STUCK_CELLS)
+  {
+    return false;
+  }
+  _stuckCellAddress[_stuckCellCount] = address & (_size - 1);
+  _stuckCellValue[_stuckCellCount] = value;
+  _stuckCellCount++;
+  return true;
+}
+
+void SramSimulator::clearFaults()
+{
+  _dataStuckHigh = 0;
+  _dataStuckLow = 0;
+  _addressStuckHigh = 0;
+  _addressStuckLow = 0;
+  _stuckCellCount = 0;
+}
+
+uint16_t SramSimulator::mapAddress(uint16_t address) const
+{
+  address = (address | _addressStuckHigh) & ~_addressStuckLow;
+  return address & (_size - 1);
+}
+
+uint8_t SramSimulator::mapData(uint8_t data) const
+{
+  return (data | _dataStuckHigh) & ~_dataStuckLow;
+}
@@ -0,0 +1,197 @@
+#include "SramTransferQueue.h"
+#include "logger.h"
+
+// Critical sections put the interrupt state back as they found it, so they
+// are also safe inside a timer ISR that calls poll().
+#if defined(__AVR__)
+typedef uint8_t InterruptState;
+
+static inline InterruptState disableInterrupts()
+{
+  InterruptState state = SREG;
+  cli();
+  return state;
+}
+
+static inline void restoreInterrupts(InterruptState state)
+{
+  SREG = state;
+}
+#elif defined(ESP8266)
+typedef uint32_t InterruptState;
+
+static inline InterruptState disableInterrupts()
+{
+  return xt_rsil(15);
+}
+
+static inline void restoreInterrupts(InterruptState state)
+{
+  xt_wsr_ps(state);
+}
+#else
+typedef uint8_t InterruptState;
+
+static inline InterruptState disableInterrupts()
+{
+  noInterrupts();
+  return 0;
+}
+
+static inline void restoreInterrupts(InterruptState)
+{
+  interrupts();
+}
+#endif
+
+/**
+ * Constructor for the background transfer queue.
+ *
+ * @param sram The SRAM chip to transfer to and from.
+ * @param capacity Maximum number of queued descriptors.
+ * @param bytesPerTick Maximum bytes moved by one poll().
+ */
+SramTransferQueue::SramTransferQueue(HY62252A *sram, uint8_t capacity, uint16_t bytesPerTick)
+    : _sram(sram), _capacity(capacity), _head(0), _tail(0), _count(0), _bytesPerTick(bytesPerTick), _busy(false)
+{
+  if (_capacity == 0)
+  {
+    _capacity = 1;
+  }
+  _queue = new SramTransfer *[_capacity];
+}
+
+SramTransferQueue::~SramTransferQueue()
+{
+  delete[] _queue;
+}
+
+/**
+ * Queues a read from SRAM into an MCU buffer.
+ *
+ * @param transfer Caller-owned descriptor, filled in by this call.
+ * @param address SRAM start address.
+ * @param buffer Buffer to read into.
+ * @param length Number of bytes.
+ * @param callback Optional completion callback.
+ * @param context Passed to the callback.
+ * @return true if queued, false if the queue is full.
+ */
+bool SramTransferQueue::submitRead(SramTransfer *transfer, uint16_t address, uint8_t *buffer, uint16_t length,
+                                   SramTransferCallback callback, void *context)
+{
+  transfer->address = address;
+  transfer->buffer = buffer;
+  transfer->length = length;
+  transfer->write = false;
+  transfer->callback = callback;
+  transfer->context = context;
+  return submit(transfer);
+}
+
+/**
+ * Queues a write from an MCU buffer into SRAM.
+ *
+ * @param transfer Caller-owned descriptor, filled in by this call.
+ * @param address SRAM start address.
+ * @param data Data to write.
+ * @param length Number of bytes.
+ * @param callback Optional completion callback.
+ * @param context Passed to the callback.
+ * @return true if queued, false if the queue is full.
+ */
+bool SramTransferQueue::submitWrite(SramTransfer *transfer, uint16_t address, const uint8_t *data, uint16_t length,
+                                    SramTransferCallback callback, void *context)
+{
+  transfer->address = address;
+  transfer->buffer = (uint8_t *)data;
+  transfer->length = length;
+  transfer->write = true;
+  transfer->callback = callback;
+  transfer->context = context;
+  return submit(transfer);
+}
+
+bool SramTransferQueue::submit(SramTransfer *transfer)
+{
+  transfer->transferred = 0;
+  transfer->done = false;
+
+  InterruptState state = disableInterrupts();
+  if (_count >= _capacity)
+  {
+    restoreInterrupts(state);
+    Logger::warning("SramTransferQueue: queue full");
+    return false;
+  }
+  _queue[_head] = transfer;
+  _head = (_head + 1) % _capacity;
+  _count++;
+  restoreInterrupts(state);
+  return true;
+}
+
+/**
+ * Moves the next slice of the oldest transfer with one burst. Completes the
+ * descriptor (flag first, then callback) once its last byte has moved.
+ *
+ * @return Number of bytes moved, 0 if idle or already inside poll().
+ */
+uint16_t SramTransferQueue::poll()
+{
+  // Claimed with interrupts off, so an ISR poll() cannot slip in between
+  InterruptState state = disableInterrupts();
+  if (_busy || _count == 0)
+  {
+    restoreInterrupts(state);
+    return 0;
+  }
+  _busy = true;
+  restoreInterrupts(state);
+
+  SramTransfer *transfer = _queue[_tail];
+  uint16_t chunk = transfer->length - transfer->transferred;
+  if (chunk > _bytesPerTick)
+  {
+    chunk = _bytesPerTick;
+  }
+
+  uint16_t address = transfer->address + transfer->transferred;
+  uint8_t *buffer = transfer->buffer + transfer->transferred;
+  if (transfer->write)
+  {
+    _sram->writeBlock(address, buffer, chunk);
+  }
+  else
+  {
+    _sram->readBlock(address, buffer, chunk);
+  }
+  transfer->transferred += chunk;
+
+  if (transfer->transferred >= transfer->length)
+  {
+    state = disableInterrupts();
+    _tail = (_tail + 1) % _capacity;
+    _count--;
+    restoreInterrupts(state);
+    transfer->done = true;
+    if (transfer->callback)
+    {
+      transfer->callback(transfer, transfer->context);
+    }
+  }
+
+  _busy = false;
+  return chunk;
+}
+
+/**
+ * Runs the queue to completion, blocking.
+ */
+void SramTransferQueue::drain()
+{
+  while (_count > 0)
+  {
+    poll();
+  }
+}
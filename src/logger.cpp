@@ -1,40 +1,86 @@
 #include "logger.h"
+#include "NumberFormat.h"
+
+LogLevel Logger::currentLogLevel = (LogLevel)LOG_LEVEL;
 
 // Logger function that checks log level before printing
 void Logger::log(LogLevel level, const String &message)
 {
-  if (level <= LOG_LEVEL) // Only log if level is <= compile-time LOG_LEVEL
+  if (printPrefix(level))
   {
-    const char *levelStr;
-    switch (level)
-    {
-    case LogLevel::ERROR:
-      levelStr = "ERROR";
-      break;
-    case LogLevel::WARNING:
-      levelStr = "WARNING";
-      break;
-    case LogLevel::INFO:
-      levelStr = "INFO";
-      break;
-    case LogLevel::TRACE:
-      levelStr = "TRACE";
-      break;
-    case LogLevel::ULTRA:
-      levelStr = "ULTRA";
-      break;
-    default:
-      levelStr = "UNKNOWN";
-    }
-    Serial.print("[");
-    Serial.print(millis());
-    Serial.print("] ");
-    Serial.print(levelStr);
-    Serial.print(": ");
     Serial.println(message);
   }
 }
 
+void Logger::log(LogLevel level, const char *message)
+{
+  if (printPrefix(level))
+  {
+    Serial.println(message);
+  }
+}
+
+void Logger::log(LogLevel level, const char *label, int32_t value, const char *suffix)
+{
+  if (printPrefix(level))
+  {
+    char number[NumberFormat::INT_SIZE];
+    NumberFormat::formatInt(number, sizeof(number), value);
+    Serial.print(label);
+    Serial.print(number);
+    Serial.println(suffix);
+  }
+}
+
+void Logger::log(LogLevel level, const char *label, float value, uint8_t decimals, const char *suffix)
+{
+  if (printPrefix(level))
+  {
+    char number[NumberFormat::FLOAT_SIZE];
+    NumberFormat::formatFloat(number, sizeof(number), value, decimals);
+    Serial.print(label);
+    Serial.print(number);
+    Serial.println(suffix);
+  }
+}
+
+bool Logger::printPrefix(LogLevel level)
+{
+  if (level > LOG_LEVEL) // Only log if level is <= compile-time LOG_LEVEL
+  {
+    return false;
+  }
+  const char *levelStr;
+  switch (level)
+  {
+  case LogLevel::ERROR:
+    levelStr = "ERROR";
+    break;
+  case LogLevel::WARNING:
+    levelStr = "WARNING";
+    break;
+  case LogLevel::INFO:
+    levelStr = "INFO";
+    break;
+  case LogLevel::TRACE:
+    levelStr = "TRACE";
+    break;
+  case LogLevel::ULTRA:
+    levelStr = "ULTRA";
+    break;
+  default:
+    levelStr = "UNKNOWN";
+  }
+  char timestamp[NumberFormat::INT_SIZE];
+  NumberFormat::formatUnsigned(timestamp, sizeof(timestamp), millis());
+  Serial.print("[");
+  Serial.print(timestamp);
+  Serial.print("] ");
+  Serial.print(levelStr);
+  Serial.print(": ");
+  return true;
+}
+
 void Logger::warning(const String &message)
 {
   log(LogLevel::WARNING, message);
@@ -55,6 +101,31 @@ void Logger::trace(const String &message)
   log(LogLevel::TRACE, message);
 }
 
+void Logger::warning(const char *message)
+{
+  log(LogLevel::WARNING, message);
+}
+
+void Logger::error(const char *message)
+{
+  log(LogLevel::ERROR, message);
+}
+
+void Logger::info(const char *message)
+{
+  log(LogLevel::INFO, message);
+}
+
+void Logger::trace(const char *message)
+{
+  log(LogLevel::TRACE, message);
+}
+
+void Logger::ultra(const char *message)
+{
+  log(LogLevel::ULTRA, message);
+}
+
 void Logger::setLogLevel(LogLevel newLevel)
 {
   currentLogLevel = newLevel;
@@ -1,6 +1,10 @@
 #include <Arduino.h>
 #include "HY62252A.h"
 #include "ShiftRegister74HC595.h"
+#include "SramMarchTest.h"
+#include "SramSimulator.h"
+#include "NumberFormat.h"
+#include "PowerScheduler.h"
 #include "logger.h"
 #if LOG_LEVEL == 3
 // Define whether you're using shift registers or direct GPIO for the address lines
@@ -339,9 +343,131 @@ void fullTestShifterSRAM()
   // Optionally, add a delay between tests to slow things down for observation
   delay(1000);
 
+  Logger::info("-----------------------------Starting full-chip march test...");
+  SramMarchTest marchTest(&sram);
+  marchTest.run();
+  marchTest.printReport();
+
   Logger::info("SRAM test completed.");
 }
 #endif
+
+#if TEST_SRAM_SIMULATOR
+// Simulated 32K chip, needs the RAM of an ESP8266 (or bigger)
+uint8_t simulatedChip[0x8000];
+SramSimulator simulatedSram(simulatedChip, sizeof(simulatedChip));
+
+// Run the march test against the simulator with one injected fault
+void runSimulatedFault(const char *name, bool expectPass)
+{
+  SramMarchTest marchTest(&simulatedSram);
+  const SramTestReport &report = marchTest.run();
+  Logger::info(String(name) + ": " + (report.passed == expectPass ? "result as expected" : "UNEXPECTED RESULT"));
+  marchTest.printReport();
+  simulatedSram.clearFaults();
+}
+
+void simulatedSramTest()
+{
+  Logger::info("SRAM march test self-check against the simulator");
+  runSimulatedFault("No faults", true);
+  simulatedSram.injectDataLineStuck(5, false);
+  runSimulatedFault("Data line 5 stuck low", false);
+  simulatedSram.injectAddressLineStuck(9, true);
+  runSimulatedFault("Address line 9 stuck high", false);
+  simulatedSram.injectStuckCell(0x1234, 0xA5);
+  runSimulatedFault("Stuck cell at 0x1234", false);
+}
+#endif
+
+#if NUMBER_FORMAT_BENCHMARK
+const uint16_t BENCHMARK_ROUNDS = 1000;
+volatile uint8_t benchmarkSink; // Keeps the conversions from being optimized away
+
+// Cycles per conversion, from the elapsed micros() of BENCHMARK_ROUNDS conversions
+uint32_t cyclesPerConversion(unsigned long startMicros)
+{
+  return (micros() - startMicros) * (F_CPU / 1000000UL) / BENCHMARK_ROUNDS;
+}
+
+void numberFormatBenchmark()
+{
+  Logger::info("Number formatting, cycles per conversion (String vs NumberFormat)");
+  char buffer[NumberFormat::FLOAT_SIZE];
+  unsigned long start;
+
+  start = micros();
+  for (uint16_t i = 0; i < BENCHMARK_ROUNDS; i++)
+  {
+    String text(30000L + i);
+    benchmarkSink = text[0];
+  }
+  Logger::log(INFO, "int   String:       ", (int32_t)cyclesPerConversion(start));
+
+  start = micros();
+  for (uint16_t i = 0; i < BENCHMARK_ROUNDS; i++)
+  {
+    NumberFormat::formatInt(buffer, sizeof(buffer), 30000L + i);
+    benchmarkSink = buffer[0];
+  }
+  Logger::log(INFO, "int   NumberFormat: ", (int32_t)cyclesPerConversion(start));
+
+  start = micros();
+  for (uint16_t i = 0; i < BENCHMARK_ROUNDS; i++)
+  {
+    String text(3.7f + i * 0.01f, 2);
+    benchmarkSink = text[0];
+  }
+  Logger::log(INFO, "float String:       ", (int32_t)cyclesPerConversion(start));
+
+  start = micros();
+  for (uint16_t i = 0; i < BENCHMARK_ROUNDS; i++)
+  {
+    NumberFormat::formatFloat(buffer, sizeof(buffer), 3.7f + i * 0.01f, 2);
+    benchmarkSink = buffer[0];
+  }
+  Logger::log(INFO, "float NumberFormat: ", (int32_t)cyclesPerConversion(start));
+}
+#endif
+
+#if POWER_SCHEDULER_SIMULATION
+// Supply current of an ATmega328P at 16 MHz / 5 V, and in power-down with the watchdog running
+#define SIM_ACTIVE_MICROAMPS 15000UL
+#define SIM_SLEEP_MICROAMPS 6UL
+const uint32_t SIM_DURATION_MILLIS = 600000UL; // 10 simulated minutes
+
+BatteryManager simulatedBattery(A0);
+
+// Sleeping is simulated: virtual time passes at once, the battery is really sampled
+void simulatedSleep(uint32_t duration)
+{
+  (void)duration;
+}
+
+void powerSchedulerSimulation()
+{
+  Logger::info("Power scheduler duty cycle simulation");
+  simulatedBattery.configureSampling(2, 3, 3);
+  PowerScheduler::setSleepHook(simulatedSleep);
+  PowerScheduler::begin();
+  PowerScheduler::addBattery(&simulatedBattery, 1000);
+
+  uint32_t start = PowerScheduler::now();
+  while (PowerScheduler::now() - start < SIM_DURATION_MILLIS)
+  {
+    PowerScheduler::runOnce();
+  }
+  PowerScheduler::printStats();
+
+  // Average current against staying awake in a polling loop
+  uint32_t awake = PowerScheduler::getAwakeMillis();
+  uint32_t asleep = PowerScheduler::getSleepMillis();
+  uint32_t average = (uint32_t)(((uint64_t)awake * SIM_ACTIVE_MICROAMPS + (uint64_t)asleep * SIM_SLEEP_MICROAMPS) / (awake + asleep));
+  Logger::log(INFO, "Average current uA: ", (int32_t)average);
+  Logger::log(INFO, "Always awake uA: ", (int32_t)SIM_ACTIVE_MICROAMPS);
+  Logger::log(INFO, "Battery life factor: ", (float)SIM_ACTIVE_MICROAMPS / average, 1, "x");
+}
+#endif
 void setup()
 {
 #if SIMPLE_SHIFTER_TEST
@@ -365,6 +491,15 @@ void setup()
 
   // Final report
   finalReport();
+#elif TEST_SRAM_SIMULATOR
+  Serial.begin(115200);
+  simulatedSramTest();
+#elif NUMBER_FORMAT_BENCHMARK
+  Serial.begin(115200);
+  numberFormatBenchmark();
+#elif POWER_SCHEDULER_SIMULATION
+  Serial.begin(115200);
+  powerSchedulerSimulation();
 #else
   fullTestShifterSRAM();
 #endif
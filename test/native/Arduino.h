@@ -0,0 +1,187 @@
+// test/native/Arduino.h
+// Minimal Arduino core for the native unit tests (env:native): simulated
+// time and ADC, pins routed to a board model the test provides (no-ops
+// otherwise), no-op interrupts, and a Serial that discards output.
+// Header only, so the tests need no extra build setup; shared state lives in
+// function-local statics of inline functions.
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define LSBFIRST 0
+#define MSBFIRST 1
+#define DEC 10
+#define HEX 16
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define A6 20
+#define A7 21
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+#define F(string) string
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+// Simulated time in microseconds; only delays, ADC conversions and the tests move it.
+inline unsigned long &nativeMicros()
+{
+  static unsigned long micros = 0;
+  return micros;
+}
+
+inline void nativeAdvanceMicros(unsigned long duration) { nativeMicros() += duration; }
+
+// Value every analogRead() returns.
+inline int &nativeAnalogValue()
+{
+  static int value = 0;
+  return value;
+}
+
+// Time one conversion takes on an AVR at the default ADC clock.
+static const unsigned long NATIVE_ANALOG_READ_MICROS = 112;
+
+inline unsigned long micros() { return nativeMicros(); }
+inline unsigned long millis() { return nativeMicros() / 1000; }
+inline void delay(unsigned long duration) { nativeMicros() += duration * 1000; }
+inline void delayMicroseconds(unsigned int duration) { nativeMicros() += duration; }
+inline int analogRead(uint8_t)
+{
+  nativeMicros() += NATIVE_ANALOG_READ_MICROS;
+  return nativeAnalogValue();
+}
+inline void analogReference(uint8_t) {}
+// Hardware a test wires to the pins; unset hooks do nothing (reads are LOW).
+struct NativeBoard
+{
+  void (*pinWrite)(uint8_t pin, uint8_t value);
+  int (*pinRead)(uint8_t pin);
+  void (*shiftOut)(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value);
+};
+
+inline NativeBoard &nativeBoard()
+{
+  static NativeBoard board = {nullptr, nullptr, nullptr};
+  return board;
+}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t value)
+{
+  if (nativeBoard().pinWrite)
+  {
+    nativeBoard().pinWrite(pin, value);
+  }
+}
+inline int digitalRead(uint8_t pin) { return nativeBoard().pinRead ? nativeBoard().pinRead(pin) : LOW; }
+inline void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value)
+{
+  if (nativeBoard().shiftOut)
+  {
+    nativeBoard().shiftOut(dataPin, clockPin, bitOrder, value);
+  }
+}
+inline void attachInterrupt(uint8_t, void (*)(void), int) {}
+inline void detachInterrupt(uint8_t) {}
+inline int digitalPinToInterrupt(int pin) { return pin; }
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline void yield() {}
+
+class String
+{
+public:
+  String(const char *text = "") : _text(text ? text : "") {}
+  String(const std::string &text) : _text(text) {}
+  String(char value) : _text(1, value) {}
+  String(unsigned char value, int base = DEC) : _text(number(value, base)) {}
+  String(int value, int base = DEC) : _text(number(value, base)) {}
+  String(unsigned int value, int base = DEC) : _text(number(value, base)) {}
+  String(long value, int base = DEC) : _text(number(value, base)) {}
+  String(unsigned long value, int base = DEC) : _text(number(value, base)) {}
+  String(float value, int decimals = 2)
+  {
+    char text[48];
+    snprintf(text, sizeof(text), "%.*f", decimals, value);
+    _text = text;
+  }
+
+  String &operator+=(const String &other)
+  {
+    _text += other._text;
+    return *this;
+  }
+  friend String operator+(const String &left, const String &right) { return String(left._text + right._text); }
+  bool operator==(const char *other) const { return _text == other; }
+
+  const char *c_str() const { return _text.c_str(); }
+  unsigned int length() const { return _text.length(); }
+  char charAt(unsigned int index) const { return index < _text.length() ? _text[index] : 0; }
+
+private:
+  static std::string number(long long value, int base)
+  {
+    char text[24];
+    snprintf(text, sizeof(text), base == HEX ? "%llx" : "%lld", value);
+    return text;
+  }
+
+  std::string _text;
+};
+
+// Accepts everything the library prints and throws it away.
+class HardwareSerial
+{
+public:
+  void begin(unsigned long) {}
+  template <typename T>
+  size_t print(const T &)
+  {
+    return 0;
+  }
+  template <typename T>
+  size_t print(const T &, int)
+  {
+    return 0;
+  }
+  template <typename T>
+  size_t println(const T &)
+  {
+    return 0;
+  }
+  template <typename T>
+  size_t println(const T &, int)
+  {
+    return 0;
+  }
+  size_t println() { return 0; }
+  size_t write(uint8_t) { return 1; }
+  size_t write(const uint8_t *, size_t length) { return length; }
+  void flush() {}
+};
+
+static HardwareSerial Serial __attribute__((unused));
+
+#endif // NATIVE_ARDUINO_H
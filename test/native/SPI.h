@@ -0,0 +1,6 @@
+// test/native/SPI.h
+// Empty stand-in: ShiftRegister74HC595.h includes SPI.h but shifts with shiftOut().
+#ifndef NATIVE_SPI_H
+#define NATIVE_SPI_H
+
+#endif // NATIVE_SPI_H
@@ -0,0 +1,161 @@
+// test/native/Wire.h
+// Wire for the native unit tests: 24LC32A EEPROMs (4 KB, 32-byte pages) at
+// 0x50 + the device address, every other address NACKs. Writes wrap inside
+// their page like the real chip. The chips answer at once (no write cycle);
+// each transaction takes its bus time at 100 kHz from the simulated clock.
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include <Arduino.h>
+
+#define BUFFER_LENGTH 32
+
+// Bus time of one byte at 100 kHz (8 bits and the ack).
+static const unsigned long NATIVE_I2C_BYTE_MICROS = 90;
+
+struct NativeEeprom
+{
+  uint8_t memory[8][4096];
+  bool present[8];
+  unsigned long pageWrites;
+  long writesUntilPowerLoss; // Page writes until a simulated power loss, -1 for none
+  uint16_t pointer[8];
+  uint8_t address;
+  uint8_t transmit[BUFFER_LENGTH];
+  uint8_t transmitLength;
+  uint8_t receive[BUFFER_LENGTH];
+  uint8_t receiveLength;
+  uint8_t receivePosition;
+};
+
+// The simulated chips. Device 0 is present, memory starts erased (0xFF).
+inline NativeEeprom &nativeEeprom()
+{
+  static NativeEeprom eeprom;
+  static bool initialized = false;
+  if (!initialized)
+  {
+    memset(&eeprom, 0, sizeof(eeprom));
+    memset(eeprom.memory, 0xFF, sizeof(eeprom.memory));
+    eeprom.present[0] = true;
+    eeprom.writesUntilPowerLoss = -1;
+    initialized = true;
+  }
+  return eeprom;
+}
+
+class TwoWire
+{
+public:
+  void begin() {}
+  void setClock(uint32_t) {}
+
+  void beginTransmission(uint8_t address)
+  {
+    nativeEeprom().address = address;
+    nativeEeprom().transmitLength = 0;
+  }
+  void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+
+  size_t write(uint8_t data)
+  {
+    NativeEeprom &eeprom = nativeEeprom();
+    if (eeprom.transmitLength >= BUFFER_LENGTH)
+    {
+      return 0;
+    }
+    eeprom.transmit[eeprom.transmitLength++] = data;
+    return 1;
+  }
+  size_t write(const uint8_t *data, size_t length)
+  {
+    size_t written = 0;
+    while (length-- > 0)
+    {
+      written += write(*data++);
+    }
+    return written;
+  }
+
+  uint8_t endTransmission(bool stop = true)
+  {
+    (void)stop;
+    NativeEeprom &eeprom = nativeEeprom();
+    nativeAdvanceMicros((1 + eeprom.transmitLength) * NATIVE_I2C_BYTE_MICROS);
+    int device = chip(eeprom.address);
+    if (device < 0)
+    {
+      return 2;
+    }
+    if (eeprom.transmitLength >= 2)
+    {
+      eeprom.pointer[device] = ((eeprom.transmit[0] << 8) | eeprom.transmit[1]) & 0xFFF;
+    }
+    if (eeprom.transmitLength > 2)
+    {
+      // Power lost during the write cycle: the bytes are left erased and the chip is gone
+      bool powerLoss = eeprom.writesUntilPowerLoss >= 0 && eeprom.writesUntilPowerLoss-- == 0;
+      uint16_t page = eeprom.pointer[device] & ~31;
+      for (uint8_t i = 2; i < eeprom.transmitLength; i++)
+      {
+        eeprom.memory[device][eeprom.pointer[device]] = powerLoss ? 0xFF : eeprom.transmit[i];
+        eeprom.pointer[device] = page | ((eeprom.pointer[device] + 1) & 31);
+      }
+      if (powerLoss)
+      {
+        eeprom.present[device] = false;
+        return 2;
+      }
+      eeprom.pageWrites++;
+    }
+    return 0;
+  }
+  uint8_t endTransmission(uint8_t stop) { return endTransmission((bool)stop); }
+
+  uint8_t requestFrom(uint8_t address, uint8_t length, uint8_t stop = true)
+  {
+    (void)stop;
+    NativeEeprom &eeprom = nativeEeprom();
+    eeprom.receiveLength = 0;
+    eeprom.receivePosition = 0;
+    nativeAdvanceMicros((1 + length) * NATIVE_I2C_BYTE_MICROS);
+    int device = chip(address);
+    if (device < 0)
+    {
+      return 0;
+    }
+    if (length > BUFFER_LENGTH)
+    {
+      length = BUFFER_LENGTH;
+    }
+    for (uint8_t i = 0; i < length; i++)
+    {
+      eeprom.receive[eeprom.receiveLength++] = eeprom.memory[device][eeprom.pointer[device]];
+      eeprom.pointer[device] = (eeprom.pointer[device] + 1) & 0xFFF;
+    }
+    return length;
+  }
+  uint8_t requestFrom(int address, int length) { return requestFrom((uint8_t)address, (uint8_t)length); }
+
+  int available() { return nativeEeprom().receiveLength - nativeEeprom().receivePosition; }
+  int read()
+  {
+    NativeEeprom &eeprom = nativeEeprom();
+    return eeprom.receivePosition < eeprom.receiveLength ? eeprom.receive[eeprom.receivePosition++] : -1;
+  }
+
+private:
+  // Index of the chip answering at an address, -1 if none.
+  static int chip(uint8_t address)
+  {
+    if (address < 0x50 || address > 0x57 || !nativeEeprom().present[address - 0x50])
+    {
+      return -1;
+    }
+    return address - 0x50;
+  }
+};
+
+static TwoWire Wire __attribute__((unused));
+
+#endif // NATIVE_WIRE_H
@@ -0,0 +1,75 @@
+// test/native/test_battery_manager/test_main.cpp
+#include <Arduino.h>
+#include <unity.h>
+#include "BatteryManager.h"
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_state_of_charge_endpoints(void)
+{
+  TEST_ASSERT_EQUAL_UINT16(0, BatteryManager::stateOfChargeFromCell(0));
+  TEST_ASSERT_EQUAL_UINT16(0, BatteryManager::stateOfChargeFromCell(2500));
+  TEST_ASSERT_EQUAL_UINT16(0, BatteryManager::stateOfChargeFromCell(3000));
+  TEST_ASSERT_EQUAL_UINT16(1000, BatteryManager::stateOfChargeFromCell(4200));
+  TEST_ASSERT_EQUAL_UINT16(1000, BatteryManager::stateOfChargeFromCell(4350));
+  TEST_ASSERT_EQUAL_UINT16(1000, BatteryManager::stateOfChargeFromCell(0xFFFF));
+}
+
+void test_state_of_charge_curve_points(void)
+{
+  // The 10% steps listed in BatteryManager.h
+  static const uint16_t points[] = {3000, 3350, 3460, 3540, 3620, 3700, 3790, 3880, 3960, 4050, 4200};
+  for (uint8_t i = 0; i < sizeof(points) / sizeof(points[0]); i++)
+  {
+    TEST_ASSERT_UINT16_WITHIN(1, i * 100, BatteryManager::stateOfChargeFromCell(points[i]));
+  }
+  // Halfway along a segment is halfway between its steps
+  TEST_ASSERT_UINT16_WITHIN(2, 550, BatteryManager::stateOfChargeFromCell(3745));
+}
+
+void test_state_of_charge_is_monotonic(void)
+{
+  uint16_t previous = 0;
+  for (uint16_t millivolts = 2900; millivolts <= 4300; millivolts++)
+  {
+    uint16_t charge = BatteryManager::stateOfChargeFromCell(millivolts);
+    TEST_ASSERT_GREATER_OR_EQUAL(previous, charge);
+    TEST_ASSERT_LESS_OR_EQUAL(1000, charge);
+    previous = charge;
+  }
+  TEST_ASSERT_EQUAL_UINT16(1000, previous);
+}
+
+void test_default_full_scale_is_the_pack_voltage(void)
+{
+  // Two cells, full scale 8.4 V: a full ADC reading is a full pack
+  BatteryManager full(A0);
+  nativeAnalogValue() = 1023;
+  full.getBatteryAdjustedLevel();
+  TEST_ASSERT_UINT16_WITHIN(5, 8400, full.getBatteryMillivolts());
+  TEST_ASSERT_EQUAL_UINT16(1000, full.getStateOfCharge());
+  TEST_ASSERT_FALSE(full.isBatteryCritical());
+
+  // 7.4 V is 3.7 V per cell, about half
+  BatteryManager half(A0);
+  nativeAnalogValue() = 1023L * 7400 / 8400;
+  TEST_ASSERT_UINT16_WITHIN(20, 500, half.getBatteryAdjustedLevel() * 10);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_state_of_charge_endpoints);
+  RUN_TEST(test_state_of_charge_curve_points);
+  RUN_TEST(test_state_of_charge_is_monotonic);
+  RUN_TEST(test_default_full_scale_is_the_pack_voltage);
+  return UNITY_END();
+}
@@ -0,0 +1,69 @@
+// test/native/test_crc/test_main.cpp
+#include <Arduino.h>
+#include <unity.h>
+#include "Crc.h"
+
+const uint8_t CHECK_INPUT[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_check_values(void)
+{
+  // Catalogue check values: CRC-8 (SMBus) and CRC-16/CCITT-FALSE
+  TEST_ASSERT_EQUAL_HEX8(0xF4, Crc::crc8(CHECK_INPUT, sizeof(CHECK_INPUT)));
+  TEST_ASSERT_EQUAL_HEX16(0x29B1, Crc::crc16(CHECK_INPUT, sizeof(CHECK_INPUT)));
+  TEST_ASSERT_EQUAL_HEX8(Crc::CRC8_INIT, Crc::crc8(CHECK_INPUT, 0));
+  TEST_ASSERT_EQUAL_HEX16(Crc::CRC16_INIT, Crc::crc16(CHECK_INPUT, 0));
+}
+
+void test_incremental_matches_one_shot(void)
+{
+  uint8_t crc8 = Crc::CRC8_INIT;
+  uint16_t crc16 = Crc::CRC16_INIT;
+  for (uint8_t i = 0; i < sizeof(CHECK_INPUT); i++)
+  {
+    crc8 = Crc::crc8Update(crc8, CHECK_INPUT[i]);
+    crc16 = Crc::crc16Update(crc16, CHECK_INPUT[i]);
+  }
+  TEST_ASSERT_EQUAL_HEX8(Crc::crc8(CHECK_INPUT, sizeof(CHECK_INPUT)), crc8);
+  TEST_ASSERT_EQUAL_HEX16(Crc::crc16(CHECK_INPUT, sizeof(CHECK_INPUT)), crc16);
+
+  // Continuing from a partial result, as the block scrubber does
+  TEST_ASSERT_EQUAL_HEX8(crc8, Crc::crc8(CHECK_INPUT + 4, 5, Crc::crc8(CHECK_INPUT, 4)));
+  TEST_ASSERT_EQUAL_HEX16(crc16, Crc::crc16(CHECK_INPUT + 4, 5, Crc::crc16(CHECK_INPUT, 4)));
+}
+
+void test_every_single_bit_error_is_detected(void)
+{
+  uint8_t block[64];
+  for (uint8_t i = 0; i < sizeof(block); i++)
+  {
+    block[i] = i * 37 + 11;
+  }
+  uint8_t good8 = Crc::crc8(block, sizeof(block));
+  uint16_t good16 = Crc::crc16(block, sizeof(block));
+  for (uint16_t bit = 0; bit < sizeof(block) * 8; bit++)
+  {
+    block[bit / 8] ^= 1 << (bit % 8);
+    TEST_ASSERT_TRUE(Crc::crc8(block, sizeof(block)) != good8);
+    TEST_ASSERT_TRUE(Crc::crc16(block, sizeof(block)) != good16);
+    block[bit / 8] ^= 1 << (bit % 8);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_check_values);
+  RUN_TEST(test_incremental_matches_one_shot);
+  RUN_TEST(test_every_single_bit_error_is_detected);
+  return UNITY_END();
+}
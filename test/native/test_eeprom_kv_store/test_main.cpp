@@ -0,0 +1,161 @@
+// test/native/test_eeprom_kv_store/test_main.cpp
+#include <Arduino.h>
+#include <Wire.h>
+#include <unity.h>
+#include "Crc.h"
+#include "EepromKvStore.h"
+
+// Small regions, so a few hundred writes go round the log many times
+const uint16_t REGION_START = 1024;
+const uint16_t REGION_SIZE = 128;
+
+void setUp(void)
+{
+  NativeEeprom &eeprom = nativeEeprom();
+  memset(eeprom.memory[0], 0xFF, sizeof(eeprom.memory[0]));
+  eeprom.present[0] = true;
+  eeprom.writesUntilPowerLoss = -1;
+}
+
+void tearDown(void)
+{
+}
+
+void test_values_survive_a_reboot(void)
+{
+  EEPROM24LC32A eeprom;
+  EepromKvStore store(&eeprom, REGION_START, REGION_SIZE);
+  TEST_ASSERT_TRUE(store.format());
+  TEST_ASSERT_TRUE(store.begin());
+  TEST_ASSERT_EQUAL_UINT8(0, store.count());
+
+  float threshold = 3.3f;
+  TEST_ASSERT_TRUE(store.put(1, threshold));
+  TEST_ASSERT_TRUE(store.put(2, (uint16_t)1500));
+  TEST_ASSERT_TRUE(store.put(3, (uint8_t)7));
+  TEST_ASSERT_TRUE(store.remove(3));
+  TEST_ASSERT_FALSE(store.remove(3));
+
+  // Writing the value a key already holds does nothing
+  uint32_t writes = store.getPageWrites();
+  TEST_ASSERT_TRUE(store.put(1, threshold));
+  TEST_ASSERT_EQUAL_UINT32(writes, store.getPageWrites());
+
+  EEPROM24LC32A rebooted;
+  EepromKvStore scanned(&rebooted, REGION_START, REGION_SIZE);
+  TEST_ASSERT_TRUE(scanned.begin());
+  TEST_ASSERT_EQUAL_UINT8(2, scanned.count());
+  float storedThreshold = 0;
+  uint16_t storedCurrent = 0;
+  TEST_ASSERT_TRUE(scanned.get(1, storedThreshold));
+  TEST_ASSERT_TRUE(storedThreshold == threshold);
+  TEST_ASSERT_TRUE(scanned.get(2, storedCurrent));
+  TEST_ASSERT_EQUAL_UINT16(1500, storedCurrent);
+  TEST_ASSERT_FALSE(scanned.contains(3));
+  // Wrong size
+  uint8_t small;
+  TEST_ASSERT_FALSE(scanned.get(2, small));
+}
+
+void test_garbage_collection_keeps_cold_keys(void)
+{
+  EEPROM24LC32A eeprom;
+  EepromKvStore store(&eeprom, REGION_START, REGION_SIZE);
+  TEST_ASSERT_TRUE(store.format() && store.begin());
+  TEST_ASSERT_TRUE(store.put(9, (int32_t)1234));
+  TEST_ASSERT_TRUE(store.put(8, (int32_t)1));
+  TEST_ASSERT_TRUE(store.remove(8));
+  for (int32_t i = 0; i < 1000; i++)
+  {
+    TEST_ASSERT_TRUE(store.put(i % 3, i));
+  }
+  TEST_ASSERT_GREATER_THAN(0, store.getRelocations());
+
+  EEPROM24LC32A rebooted;
+  EepromKvStore scanned(&rebooted, REGION_START, REGION_SIZE);
+  TEST_ASSERT_TRUE(scanned.begin());
+  int32_t value = 0;
+  TEST_ASSERT_TRUE(scanned.get(9, value));
+  TEST_ASSERT_EQUAL_INT32(1234, value);
+  TEST_ASSERT_FALSE(scanned.contains(8));
+  TEST_ASSERT_TRUE(scanned.get(2, value));
+  TEST_ASSERT_EQUAL_INT32(998, value);
+  TEST_ASSERT_EQUAL_UINT8(4, scanned.count());
+
+  // Nothing outside the region was touched
+  for (uint16_t address = 0; address < REGION_START; address++)
+  {
+    TEST_ASSERT_EQUAL_HEX8(0xFF, nativeEeprom().memory[0][address]);
+  }
+}
+
+void test_power_loss_during_writes_keeps_live_keys(void)
+{
+  // Lose power at every page write of a run that goes round the log several times
+  for (long lossAt = 0; lossAt < 120; lossAt++)
+  {
+    setUp();
+    EEPROM24LC32A eeprom;
+    EepromKvStore store(&eeprom, REGION_START, REGION_SIZE);
+    TEST_ASSERT_TRUE(store.format() && store.begin());
+    for (int32_t key = 10; key < 14; key++)
+    {
+      TEST_ASSERT_TRUE(store.put(key, key * 100));
+    }
+    nativeEeprom().writesUntilPowerLoss = lossAt;
+    for (int32_t i = 0; i < 60 && store.put(i % 2, i); i++)
+    {
+    }
+    nativeEeprom().present[0] = true;
+    nativeEeprom().writesUntilPowerLoss = -1;
+
+    EEPROM24LC32A rebooted;
+    EepromKvStore scanned(&rebooted, REGION_START, REGION_SIZE);
+    TEST_ASSERT_TRUE(scanned.begin());
+    for (int32_t key = 10; key < 14; key++)
+    {
+      int32_t value = 0;
+      TEST_ASSERT_TRUE(scanned.get(key, value));
+      TEST_ASSERT_EQUAL_INT32(key * 100, value);
+    }
+  }
+}
+
+void test_too_many_keys_refuses_writes(void)
+{
+  // One more single-byte record than the index holds, four per page
+  for (uint8_t key = 0; key <= EEPROM_KV_MAX_KEYS; key++)
+  {
+    uint8_t *record = nativeEeprom().memory[0] + REGION_START + (key / 4) * EEPROM24LC32A::PAGE_SIZE + (key % 4) * 6;
+    record[0] = key;
+    record[1] = 1;
+    record[2] = key;
+    record[3] = 0;
+    record[4] = key;
+    record[5] = Crc::crc8(record, 5);
+  }
+  EEPROM24LC32A eeprom;
+  EepromKvStore store(&eeprom, REGION_START, 256);
+  TEST_ASSERT_FALSE(store.begin());
+  uint8_t value = 0xFF;
+  TEST_ASSERT_TRUE(store.get(0, value));
+  TEST_ASSERT_EQUAL_UINT8(0, value);
+  TEST_ASSERT_FALSE(store.put(0, (uint8_t)5));
+  TEST_ASSERT_FALSE(store.remove(1));
+
+  TEST_ASSERT_TRUE(store.format());
+  TEST_ASSERT_TRUE(store.begin());
+  TEST_ASSERT_TRUE(store.put(0, (uint8_t)5));
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_values_survive_a_reboot);
+  RUN_TEST(test_garbage_collection_keeps_cold_keys);
+  RUN_TEST(test_power_loss_during_writes_keeps_live_keys);
+  RUN_TEST(test_too_many_keys_refuses_writes);
+  return UNITY_END();
+}
@@ -0,0 +1,113 @@
+// test/native/test_number_format/test_main.cpp
+#include <Arduino.h>
+#include <unity.h>
+#include "NumberFormat.h"
+
+char buffer[NumberFormat::FLOAT_SIZE + 8];
+
+void setUp(void)
+{
+  memset(buffer, 'x', sizeof(buffer));
+}
+
+void tearDown(void)
+{
+}
+
+void test_int_extremes(void)
+{
+  TEST_ASSERT_EQUAL_UINT8(11, NumberFormat::formatInt(buffer, NumberFormat::INT_SIZE, INT32_MIN));
+  TEST_ASSERT_EQUAL_STRING("-2147483648", buffer);
+  TEST_ASSERT_EQUAL_UINT8(10, NumberFormat::formatInt(buffer, NumberFormat::INT_SIZE, INT32_MAX));
+  TEST_ASSERT_EQUAL_STRING("2147483647", buffer);
+  TEST_ASSERT_EQUAL_UINT8(1, NumberFormat::formatInt(buffer, sizeof(buffer), 0));
+  TEST_ASSERT_EQUAL_STRING("0", buffer);
+  TEST_ASSERT_EQUAL_UINT8(10, NumberFormat::formatUnsigned(buffer, sizeof(buffer), UINT32_MAX));
+  TEST_ASSERT_EQUAL_STRING("4294967295", buffer);
+  NumberFormat::formatUnsigned(buffer, sizeof(buffer), 0xBEEF, 16);
+  TEST_ASSERT_EQUAL_STRING("beef", buffer);
+  NumberFormat::formatUnsigned(buffer, sizeof(buffer), 5, 2, 8, '0');
+  TEST_ASSERT_EQUAL_STRING("00000101", buffer);
+}
+
+void test_padding_with_sign(void)
+{
+  NumberFormat::formatInt(buffer, sizeof(buffer), -42, 5, '0');
+  TEST_ASSERT_EQUAL_STRING("-0042", buffer);
+  NumberFormat::formatInt(buffer, sizeof(buffer), -42, 5);
+  TEST_ASSERT_EQUAL_STRING("  -42", buffer);
+  NumberFormat::formatInt(buffer, sizeof(buffer), 42, 5, '0');
+  TEST_ASSERT_EQUAL_STRING("00042", buffer);
+  // Width below the length does not truncate
+  NumberFormat::formatInt(buffer, sizeof(buffer), -12345, 3, '0');
+  TEST_ASSERT_EQUAL_STRING("-12345", buffer);
+  NumberFormat::formatFixed(buffer, sizeof(buffer), -5, 2, 6, '0');
+  TEST_ASSERT_EQUAL_STRING("-00.05", buffer);
+  NumberFormat::formatFloat(buffer, sizeof(buffer), -1.5f, 1, 6, '0');
+  TEST_ASSERT_EQUAL_STRING("-001.5", buffer);
+}
+
+void test_float_rounding_carry(void)
+{
+  NumberFormat::formatFloat(buffer, sizeof(buffer), 9.999f, 2);
+  TEST_ASSERT_EQUAL_STRING("10.00", buffer);
+  NumberFormat::formatFloat(buffer, sizeof(buffer), -0.996f, 2);
+  TEST_ASSERT_EQUAL_STRING("-1.00", buffer);
+  NumberFormat::formatFloat(buffer, sizeof(buffer), 99.95f, 0);
+  TEST_ASSERT_EQUAL_STRING("100", buffer);
+  NumberFormat::formatFloat(buffer, sizeof(buffer), 1.005f, 1);
+  TEST_ASSERT_EQUAL_STRING("1.0", buffer);
+  NumberFormat::formatFloat(buffer, sizeof(buffer), 3.14159f, 4);
+  TEST_ASSERT_EQUAL_STRING("3.1416", buffer);
+  // No negative zero after rounding
+  NumberFormat::formatFloat(buffer, sizeof(buffer), -0.001f, 2);
+  TEST_ASSERT_EQUAL_STRING("0.00", buffer);
+  NumberFormat::formatFixed(buffer, sizeof(buffer), 1234, 2);
+  TEST_ASSERT_EQUAL_STRING("12.34", buffer);
+  NumberFormat::formatFixed(buffer, sizeof(buffer), INT32_MIN, 9);
+  TEST_ASSERT_EQUAL_STRING("-2.147483648", buffer);
+}
+
+void test_float_specials_and_overflow(void)
+{
+  NumberFormat::formatFloat(buffer, sizeof(buffer), 4294967296.0f, 2);
+  TEST_ASSERT_EQUAL_STRING("ovf", buffer);
+  NumberFormat::formatFloat(buffer, sizeof(buffer), -5e12f, 2);
+  TEST_ASSERT_EQUAL_STRING("ovf", buffer);
+  NumberFormat::formatFloat(buffer, sizeof(buffer), 4294967040.0f, 0);
+  TEST_ASSERT_EQUAL_STRING("4294967040", buffer);
+  NumberFormat::formatFloat(buffer, sizeof(buffer), NAN, 2, 5, '0');
+  TEST_ASSERT_EQUAL_STRING("  nan", buffer);
+  NumberFormat::formatFloat(buffer, sizeof(buffer), -INFINITY, 2);
+  TEST_ASSERT_EQUAL_STRING("-inf", buffer);
+}
+
+void test_buffer_too_small(void)
+{
+  // "-2147483648" needs 12 bytes with the terminator
+  TEST_ASSERT_EQUAL_UINT8(0, NumberFormat::formatInt(buffer, 11, INT32_MIN));
+  TEST_ASSERT_EQUAL_STRING("", buffer);
+  TEST_ASSERT_EQUAL_UINT8(0, NumberFormat::formatInt(buffer, 5, 7, 5));
+  TEST_ASSERT_EQUAL_STRING("", buffer);
+  TEST_ASSERT_EQUAL_UINT8(4, NumberFormat::formatInt(buffer, 5, 7, 4));
+  TEST_ASSERT_EQUAL_STRING("   7", buffer);
+  TEST_ASSERT_EQUAL_UINT8(0, NumberFormat::formatFloat(buffer, 4, 12.5f, 1));
+  TEST_ASSERT_EQUAL_STRING("", buffer);
+  // Size 0 writes nothing at all
+  buffer[0] = 'x';
+  TEST_ASSERT_EQUAL_UINT8(0, NumberFormat::formatInt(buffer, 0, 1));
+  TEST_ASSERT_EQUAL('x', buffer[0]);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_int_extremes);
+  RUN_TEST(test_padding_with_sign);
+  RUN_TEST(test_float_rounding_carry);
+  RUN_TEST(test_float_specials_and_overflow);
+  RUN_TEST(test_buffer_too_small);
+  return UNITY_END();
+}
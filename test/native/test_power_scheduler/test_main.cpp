@@ -0,0 +1,89 @@
+// test/native/test_power_scheduler/test_main.cpp
+#include <Arduino.h>
+#include <unity.h>
+#include "PowerScheduler.h"
+
+// Same setup as the POWER_SCHEDULER_SIMULATION build: one pack sampled every second
+const uint32_t SIM_DURATION_MILLIS = 600000UL;
+
+BatteryManager battery(A0);
+uint32_t hookedMillis = 0;
+uint16_t hookCalls = 0;
+
+// Sleeping is simulated: the scheduler adds the virtual time itself
+void simulatedSleep(uint32_t duration)
+{
+  hookedMillis += duration;
+  hookCalls++;
+}
+
+uint16_t counterRuns = 0;
+
+void countRun(void *context)
+{
+  (void)context;
+  counterRuns++;
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_duty_cycle_with_sleep_hook(void)
+{
+  nativeAnalogValue() = 900; // About 7.4 V: half full
+  battery.configureSampling(2, 3, 3);
+  PowerScheduler::setSleepHook(simulatedSleep);
+  PowerScheduler::begin();
+  TEST_ASSERT_TRUE(PowerScheduler::addBattery(&battery, 1000));
+
+  uint32_t start = PowerScheduler::now();
+  while (PowerScheduler::now() - start < SIM_DURATION_MILLIS)
+  {
+    PowerScheduler::runOnce();
+  }
+
+  // Awake only for the readings: 600 samples of 16 conversions
+  uint32_t awake = PowerScheduler::getAwakeMillis();
+  uint32_t asleep = PowerScheduler::getSleepMillis();
+  uint32_t expectedAwake = 600UL * 16 * NATIVE_ANALOG_READ_MICROS / 1000;
+  TEST_ASSERT_UINT32_WITHIN(expectedAwake / 50, expectedAwake, awake);
+  TEST_ASSERT_EQUAL_UINT32(hookedMillis, asleep);
+  TEST_ASSERT_UINT32_WITHIN(1000, SIM_DURATION_MILLIS, awake + asleep);
+  TEST_ASSERT_UINT16_WITHIN(5, 600, hookCalls);
+
+  uint16_t duty = PowerScheduler::getDutyCycle();
+  TEST_ASSERT_EQUAL_UINT16((uint64_t)awake * 1000 / (awake + asleep), duty);
+  TEST_ASSERT_LESS_THAN(5, duty); // Below 0.5%
+
+  TEST_ASSERT_TRUE(battery.hasReading());
+  TEST_ASSERT_EQUAL(BATTERY_OK, battery.getState());
+}
+
+void test_tasks_run_at_their_interval(void)
+{
+  PowerScheduler::resetStats();
+  TEST_ASSERT_TRUE(PowerScheduler::addTask(countRun, nullptr, 250));
+
+  uint32_t start = PowerScheduler::now();
+  while (PowerScheduler::now() - start < 10000)
+  {
+    PowerScheduler::runOnce();
+  }
+  TEST_ASSERT_UINT16_WITHIN(1, 40, counterRuns);
+  TEST_ASSERT_LESS_THAN(5, PowerScheduler::getDutyCycle());
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_duty_cycle_with_sleep_hook);
+  RUN_TEST(test_tasks_run_at_their_interval);
+  return UNITY_END();
+}
@@ -0,0 +1,148 @@
+// test/native/test_sram_bank/test_main.cpp
+#include <Arduino.h>
+#include <unity.h>
+#include "HY62252A.h"
+#include "SramBank.h"
+
+// Wiring of main.cpp: two daisy-chained 74HC595 on the same three pins, the
+// chip select bit on Q7 of the upper address register
+const uint8_t LATCH_PIN = 4;
+const uint8_t CLOCK_PIN = 5;
+const uint8_t DATA_PIN = 6;
+const uint8_t CE_PIN = 8;
+const uint8_t OE_PIN = 9;
+const uint8_t WE_PIN = 10;
+uint8_t dataPins[] = {30, 31, 32, 33, 34, 35, 36, 37};
+
+// Board model: the shift chain, the latched outputs, the buses and two chips
+uint16_t chain;   // Byte shifted first in the high half (far register)
+uint16_t latched; // Far register: A0-A7, near register: A8-A14 and the select bit
+uint8_t dataBus;
+bool ceLow, oeLow, weLow;
+uint8_t chips[2][0x8000];
+
+uint8_t selectedChip() { return (latched >> 7) & 1; }
+uint16_t latchedAddress() { return ((latched >> 8) & 0xFF) | ((latched & 0x7F) << 8); }
+
+void boardPinWrite(uint8_t pin, uint8_t value)
+{
+  if (pin == LATCH_PIN && value == HIGH)
+  {
+    latched = chain;
+  }
+  else if (pin == CE_PIN)
+  {
+    ceLow = value == LOW;
+  }
+  else if (pin == OE_PIN)
+  {
+    oeLow = value == LOW;
+  }
+  else if (pin == WE_PIN)
+  {
+    // The chip stores the bus on the rising edge of /WE
+    if (weLow && value == HIGH && ceLow)
+    {
+      chips[selectedChip()][latchedAddress()] = dataBus;
+    }
+    weLow = value == LOW;
+  }
+  else if (pin >= dataPins[0] && pin <= dataPins[7])
+  {
+    uint8_t bit = 1 << (pin - dataPins[0]);
+    dataBus = value ? dataBus | bit : dataBus & ~bit;
+  }
+}
+
+int boardPinRead(uint8_t pin)
+{
+  if (pin >= dataPins[0] && pin <= dataPins[7] && ceLow && oeLow)
+  {
+    return (chips[selectedChip()][latchedAddress()] >> (pin - dataPins[0])) & 1;
+  }
+  return LOW;
+}
+
+void boardShiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value)
+{
+  (void)bitOrder;
+  if (dataPin == DATA_PIN && clockPin == CLOCK_PIN)
+  {
+    chain = (chain << 8) | value;
+  }
+}
+
+void setUp(void)
+{
+  nativeBoard().pinWrite = boardPinWrite;
+  nativeBoard().pinRead = boardPinRead;
+  nativeBoard().shiftOut = boardShiftOut;
+  memset(chips, 0, sizeof(chips));
+}
+
+void tearDown(void)
+{
+}
+
+void test_bank_switch_at_the_same_offset(void)
+{
+  ShiftRegister74HC595 shiftRegister1(LATCH_PIN, CLOCK_PIN, DATA_PIN, 1);
+  ShiftRegister74HC595 shiftRegister2(LATCH_PIN, CLOCK_PIN, DATA_PIN, 1);
+  HY62252A sram(&shiftRegister1, &shiftRegister2, dataPins, CE_PIN, OE_PIN, WE_PIN, 8, 7);
+  sram.begin();
+  SramBank bank(&sram, &shiftRegister2, 7, 2);
+  bank.begin();
+
+  bank.writeByte(0x0005, 0x11);
+  bank.writeByte(0x8005, 0x22);
+  TEST_ASSERT_EQUAL_HEX8(0x11, chips[0][0x0005]);
+  TEST_ASSERT_EQUAL_HEX8(0x22, chips[1][0x0005]);
+
+  TEST_ASSERT_EQUAL_HEX8(0x11, bank.readByte(0x0005));
+  TEST_ASSERT_EQUAL_HEX8(0x22, bank.readByte(0x8005));
+  TEST_ASSERT_EQUAL_HEX8(0x11, bank.readByte(0x0005));
+  // Nothing landed anywhere else
+  chips[0][0x0005] = 0;
+  chips[1][0x0005] = 0;
+  for (uint16_t address = 0; address < 0x8000; address++)
+  {
+    TEST_ASSERT_EQUAL_HEX8(0, chips[0][address]);
+    TEST_ASSERT_EQUAL_HEX8(0, chips[1][address]);
+  }
+}
+
+void test_block_across_the_chip_boundary(void)
+{
+  ShiftRegister74HC595 shiftRegister1(LATCH_PIN, CLOCK_PIN, DATA_PIN, 1);
+  ShiftRegister74HC595 shiftRegister2(LATCH_PIN, CLOCK_PIN, DATA_PIN, 1);
+  HY62252A sram(&shiftRegister1, &shiftRegister2, dataPins, CE_PIN, OE_PIN, WE_PIN, 8, 7);
+  sram.begin();
+  SramBank bank(&sram, &shiftRegister2, 7, 2);
+  bank.begin();
+
+  uint8_t pattern[64];
+  for (uint8_t i = 0; i < sizeof(pattern); i++)
+  {
+    pattern[i] = i + 1;
+  }
+  bank.writeBlock(0x7FE0, pattern, sizeof(pattern));
+  TEST_ASSERT_EQUAL_MEMORY(pattern, &chips[0][0x7FE0], 32);
+  TEST_ASSERT_EQUAL_MEMORY(pattern + 32, &chips[1][0x0000], 32);
+
+  uint8_t readBack[64];
+  bank.readBlock(0x7FE0, readBack, sizeof(readBack));
+  TEST_ASSERT_EQUAL_MEMORY(pattern, readBack, sizeof(pattern));
+  // Same in-chip offset on the other chip
+  TEST_ASSERT_EQUAL_HEX8(0, bank.readByte(0xFFE0));
+  TEST_ASSERT_EQUAL_HEX8(pattern[0], bank.readByte(0x7FE0));
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_bank_switch_at_the_same_offset);
+  RUN_TEST(test_block_across_the_chip_boundary);
+  return UNITY_END();
+}
@@ -0,0 +1,84 @@
+// test/native/test_sram_march/test_main.cpp
+#include <Arduino.h>
+#include <unity.h>
+#include "SramMarchTest.h"
+#include "SramSimulator.h"
+
+// Full 32K chip, the same scenarios as the nodemcuv2_sram_simulator build
+uint8_t simulatedChip[0x8000];
+SramSimulator simulatedSram(simulatedChip, sizeof(simulatedChip));
+
+void setUp(void)
+{
+  simulatedSram.clearFaults();
+}
+
+void tearDown(void)
+{
+}
+
+void test_healthy_chip_passes(void)
+{
+  SramMarchTest marchTest(&simulatedSram);
+  const SramTestReport &report = marchTest.run();
+  TEST_ASSERT_TRUE(report.passed);
+  TEST_ASSERT_EQUAL_UINT32(0, report.failures);
+  TEST_ASSERT_EQUAL_HEX8(0, report.dataLineErrors);
+  TEST_ASSERT_EQUAL_HEX16(0, report.addressLineErrors);
+  // Walking ones (8 fills and checks) and March C- (10 passes) cover the chip many times
+  TEST_ASSERT_GREATER_THAN(18UL * sizeof(simulatedChip), report.bytesMoved);
+}
+
+void test_data_line_stuck_low(void)
+{
+  simulatedSram.injectDataLineStuck(5, false);
+  SramMarchTest marchTest(&simulatedSram);
+  const SramTestReport &report = marchTest.run();
+  TEST_ASSERT_FALSE(report.passed);
+  TEST_ASSERT_EQUAL_HEX8(1 << 5, report.dataLinesStuckLow);
+  TEST_ASSERT_EQUAL_HEX8(0, report.dataLinesStuckHigh);
+}
+
+void test_data_line_stuck_high(void)
+{
+  simulatedSram.injectDataLineStuck(0, true);
+  SramMarchTest marchTest(&simulatedSram);
+  const SramTestReport &report = marchTest.run();
+  TEST_ASSERT_FALSE(report.passed);
+  TEST_ASSERT_EQUAL_HEX8(1 << 0, report.dataLinesStuckHigh);
+  TEST_ASSERT_EQUAL_HEX8(0, report.dataLinesStuckLow);
+}
+
+void test_address_line_stuck_high(void)
+{
+  simulatedSram.injectAddressLineStuck(9, true);
+  SramMarchTest marchTest(&simulatedSram);
+  const SramTestReport &report = marchTest.run();
+  TEST_ASSERT_FALSE(report.passed);
+  TEST_ASSERT_TRUE(report.addressLineErrors & (1 << 9));
+}
+
+void test_stuck_cell(void)
+{
+  TEST_ASSERT_TRUE(simulatedSram.injectStuckCell(0x1234, 0xA5));
+  SramMarchTest marchTest(&simulatedSram);
+  TEST_ASSERT_TRUE(marchTest.testDataLines());
+  TEST_ASSERT_FALSE(marchTest.testMarchCMinus());
+  const SramTestReport &report = marchTest.getReport();
+  TEST_ASSERT_GREATER_THAN(0, report.firstFailureCount);
+  TEST_ASSERT_EQUAL_HEX16(0x1234, report.firstFailures[0]);
+  TEST_ASSERT_EQUAL_HEX16(0, report.addressLineErrors);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_healthy_chip_passes);
+  RUN_TEST(test_data_line_stuck_low);
+  RUN_TEST(test_data_line_stuck_high);
+  RUN_TEST(test_address_line_stuck_high);
+  RUN_TEST(test_stuck_cell);
+  return UNITY_END();
+}